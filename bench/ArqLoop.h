@@ -0,0 +1,259 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+//
+// The in-process line arq_bench and alloc_bench run two ArqEndpoints over:
+// a binary heap of frame arrivals and timer expiries on a picosecond clock,
+// events in the order the simulation would run them. Host is both
+// endpoints' ArqClock and ArqTransport; it checks deliveries against the
+// lines its peer sends and only counts log records.
+//
+
+#ifndef __DATALINKLAYERNETWORK_ARQLOOP_H_
+#define __DATALINKLAYERNETWORK_ARQLOOP_H_
+
+#include "Arq.h"
+
+#include <cmath>
+#include <deque>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+const double PROPAGATION_DELAY = 1.0; // As channels[*].propagationDelay in omnetpp.ini
+
+enum EventKind
+{
+    EVENT_FRAME,
+    EVENT_SEND_NEXT,
+    EVENT_RETRANSMIT,
+    EVENT_ACK,
+    EVENT_REASSEMBLY
+};
+
+struct Event
+{
+    ArqTime at;
+    uint64_t order;      // Insertion order breaks ties, as in the simulation's event queue
+    int node;
+    EventKind kind;
+    int index;           // Frame index of a retransmission timer, pool slot of a frame
+    uint32_t generation; // Timer events are stale once the generation moves on
+
+    bool operator>(const Event &other) const
+    {
+        return at != other.at ? at > other.at : order > other.order;
+    }
+};
+
+// A frame on the line, with its own copy of the payload
+struct InFlight
+{
+    ArqFrame frame;
+    std::string payload;
+};
+
+class Loop;
+
+class Host : public ArqClock, public ArqTransport
+{
+public:
+    Host(Loop &loop, int id, const ArqConfig &config, const std::vector<std::string> *expected);
+
+    ArqEndpoint arq;
+    std::vector<uint32_t> retransmitGeneration;
+    uint32_t ackGeneration = 0;
+    uint32_t reassemblyGeneration = 0;
+    long delivered = 0;
+    long mismatches = 0;
+    long records = 0;
+    long dataFrames = 0;
+
+    virtual ArqTime now() const override;
+    virtual ArqTime fromSeconds(double seconds) const override { return std::llround(seconds * 1e12); }
+    virtual double toSeconds(ArqTime time) const override { return time * 1e-12; }
+    virtual void startTimer(ArqTimer timer, int index, double delay) override;
+    virtual void cancelTimer(ArqTimer timer, int index) override;
+    virtual void scheduleSend(double delay) override;
+
+    virtual void transmit(const ArqFrame &frame, double delay) override;
+    virtual void deliver(std::string_view message, int seqNum) override;
+    virtual void log(const LogRecord &) override { records++; }
+    virtual void logDelayed(const LogRecord &, double) override { records++; }
+
+private:
+    Loop &loop;
+    int id;
+    const std::vector<std::string> *expected; // Lines the peer sends, to check deliveries against
+};
+
+class Loop
+{
+public:
+    ArqTime now = 0;
+    long events = 0;
+    std::vector<Host *> hosts;
+    double loss = 0;                        // Probability that the line drops a frame
+    long lostFrames = 0;
+    std::mt19937 random{1};
+
+    bool lose()
+    {
+        if (loss <= 0 || std::uniform_real_distribution<double>(0, 1)(random) >= loss)
+            return false;
+        lostFrames++;
+        return true;
+    }
+
+    void schedule(int node, EventKind kind, ArqTime at, int index, uint32_t generation)
+    {
+        queue.push(Event{at, order++, node, kind, index, generation});
+    }
+
+    int carry(const ArqFrame &frame)
+    {
+        int slot;
+        if (freeSlots.empty())
+        {
+            slot = pool.size();
+            pool.emplace_back();
+        }
+        else
+        {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        InFlight &copy = pool[slot];
+        copy.frame = frame;
+        copy.payload.assign(frame.payload);
+        return slot;
+    }
+
+    void run()
+    {
+        while (!queue.empty())
+        {
+            Event event = queue.top();
+            queue.pop();
+            now = event.at;
+            events++;
+
+            Host &host = *hosts[event.node];
+            switch (event.kind)
+            {
+            case EVENT_FRAME:
+            {
+                InFlight &copy = pool[event.index];
+                copy.frame.payload = copy.payload.c_str();
+                host.arq.receive(copy.frame);
+                freeSlots.push_back(event.index);
+                break;
+            }
+            case EVENT_SEND_NEXT:
+                host.arq.sendFrames();
+                break;
+            case EVENT_RETRANSMIT:
+                if (host.retransmitGeneration[event.index % host.arq.sequenceSpace()] == event.generation)
+                    host.arq.retransmitTimeout(event.index);
+                break;
+            case EVENT_ACK:
+                if (host.ackGeneration == event.generation)
+                    host.arq.ackTimeout();
+                break;
+            case EVENT_REASSEMBLY:
+                if (host.reassemblyGeneration == event.generation)
+                    host.arq.reassemblyTimeout();
+                break;
+            }
+        }
+    }
+
+private:
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> queue;
+    uint64_t order = 0;
+    std::deque<InFlight> pool;              // A deque: frames sent while one is received must not move it
+    std::vector<int> freeSlots;
+};
+
+inline Host::Host(Loop &loop, int id, const ArqConfig &config, const std::vector<std::string> *expected)
+    : arq(config, *this, *this), loop(loop), id(id), expected(expected)
+{
+    retransmitGeneration.resize(arq.sequenceSpace(), 0);
+}
+
+inline ArqTime Host::now() const
+{
+    return loop.now;
+}
+
+inline void Host::startTimer(ArqTimer timer, int index, double delay)
+{
+    ArqTime at = loop.now + fromSeconds(delay);
+    switch (timer)
+    {
+    case TIMER_RETRANSMIT:
+        loop.schedule(id, EVENT_RETRANSMIT, at, index, ++retransmitGeneration[index % arq.sequenceSpace()]);
+        break;
+    case TIMER_ACK:
+        loop.schedule(id, EVENT_ACK, at, 0, ++ackGeneration);
+        break;
+    case TIMER_REASSEMBLY:
+        loop.schedule(id, EVENT_REASSEMBLY, at, 0, ++reassemblyGeneration);
+        break;
+    }
+}
+
+inline void Host::cancelTimer(ArqTimer timer, int index)
+{
+    switch (timer)
+    {
+    case TIMER_RETRANSMIT:
+        retransmitGeneration[index % arq.sequenceSpace()]++;
+        break;
+    case TIMER_ACK:
+        ackGeneration++;
+        break;
+    case TIMER_REASSEMBLY:
+        reassemblyGeneration++;
+        break;
+    }
+}
+
+inline void Host::scheduleSend(double delay)
+{
+    loop.schedule(id, EVENT_SEND_NEXT, loop.now + fromSeconds(delay), 0, 0);
+}
+
+inline void Host::transmit(const ArqFrame &frame, double delay)
+{
+    if (frame.type == FRAME_DATA || frame.type == FRAME_AGGREGATE)
+        dataFrames++;
+    if (loop.lose())
+        return;
+    int slot = loop.carry(frame);
+    loop.schedule(1 - id, EVENT_FRAME, loop.now + fromSeconds(delay + PROPAGATION_DELAY), slot, 0);
+}
+
+inline void Host::deliver(std::string_view message, int)
+{
+    if (expected && (delivered >= (long)expected->size() ||
+                     std::string_view((*expected)[delivered]).substr(5) != message))
+        mismatches++;
+    delivered++;
+}
+
+
+#endif
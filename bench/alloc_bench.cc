@@ -0,0 +1,220 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+//
+// Heap allocations per frame on the sender's frame assembly and logging
+// path: the std::string temporaries the node used to build, against a
+// real sender and receiver (ArqEndpoint on the arq_bench line) with the
+// per-event arena and log sink they use now. Counts every operator new,
+// and reports the share made in the endpoints apart from the host's.
+//
+// Usage: alloc_bench [input file] [frames]
+//
+
+#include "ArqLoop.h"
+#include "Crc.h"
+#include "Framing.h"
+#include "LogFormat.h"
+
+#include <bitset>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static long allocations = 0;
+static long hostAllocations = 0; // Of those, made in host code
+static bool inHost = false;
+
+void *operator new(std::size_t size)
+{
+    allocations++;
+    if (inHost)
+        hostAllocations++;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+// logEvent() before the log sink: a stream opened for every line
+static void legacyLog(const std::string &event)
+{
+    std::ofstream logFile("/dev/null", std::ios::app);
+    logFile << "At time [" << 1.5 << "], Node[" << 0 << "]: " << event << "\n";
+    logFile.close();
+}
+
+// Work one sent frame costs, as the node did it before the arena and log sink
+static size_t legacyFrame(const std::string &line, std::vector<std::string> &log)
+{
+    std::string message = line;
+    std::string data = message.substr(5);
+    std::string errorCode = message.substr(0, 4);
+    std::string payload = data; // Sender window copy
+
+    std::ostringstream framed;
+    framed << '$';
+    for (char c : payload)
+    {
+        if (c == '$' || c == '/')
+            framed << '/';
+        framed << c;
+    }
+    framed << '$';
+    std::string framedPayload = framed.str();
+    char crc = (char)crc8Update(CRC8_INIT, framedPayload.data(), framedPayload.size());
+    std::string wirePayload = framedPayload; // FEC stage, a copy when disabled
+
+    std::string event = "Introducing channel error with code =[" + errorCode + "]";
+    std::string sentPayload = wirePayload; // simulateErrors() reads it back
+    std::string state = "[sent] frame with seq_num=[" + std::to_string(3) +
+                        "] and payload=[" + sentPayload +
+                        "] and trailer=[" + std::bitset<8>(crc).to_string() +
+                        "] , Modified [-1], Lost [No], Duplicate [0], Delay [0]";
+    log[0] = state;
+    legacyLog(event);
+    legacyLog(log[0]); // Written by the later "Print" event
+    return event.size() + state.size();
+}
+
+// The node's sender and receiver as they run now: two ArqEndpoints on
+// the arq_bench line, logging through a LogSink as Node::logRecord does.
+// Allocations made while the host runs are counted on their own, since
+// the node's host code is the simulation's and not this loop's.
+class CountingHost : public Host
+{
+public:
+    CountingHost(Loop &loop, int id, const ArqConfig &config, const std::vector<std::string> *expected, LogSink &sink)
+        : Host(loop, id, config, expected), sink(sink), id(id) {}
+
+    virtual void startTimer(ArqTimer timer, int index, double delay) override
+    {
+        HostScope scope;
+        Host::startTimer(timer, index, delay);
+    }
+    virtual void cancelTimer(ArqTimer timer, int index) override
+    {
+        HostScope scope;
+        Host::cancelTimer(timer, index);
+    }
+    virtual void scheduleSend(double delay) override
+    {
+        HostScope scope;
+        Host::scheduleSend(delay);
+    }
+    virtual void transmit(const ArqFrame &frame, double delay) override
+    {
+        HostScope scope;
+        Host::transmit(frame, delay);
+    }
+    virtual void deliver(std::string_view message, int seqNum) override
+    {
+        HostScope scope;
+        Host::deliver(message, seqNum);
+    }
+    virtual void log(const LogRecord &record) override
+    {
+        HostScope scope;
+        write(record);
+    }
+    virtual void logDelayed(const LogRecord &record, double) override
+    {
+        HostScope scope;
+        write(record); // The node writes it from a later "Print" event
+    }
+
+private:
+    struct HostScope
+    {
+        bool outer = inHost;
+        HostScope() { inHost = true; }
+        ~HostScope() { inHost = outer; }
+    };
+
+    LogSink &sink;
+    int id;
+
+    void write(const LogRecord &record)
+    {
+        records++;
+        char time[32];
+        ArqTime t = now(); // Picoseconds
+        std::snprintf(time, sizeof(time), "%lld.%012lld", (long long)(t / 1000000000000), (long long)(t % 1000000000000));
+        writePrefix(sink, time, id);
+        writeRecord(sink, record);
+        sink.endLine();
+    }
+};
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> lines;
+    std::ifstream in(argc > 1 ? argv[1] : "../simulations/input0.txt");
+    for (std::string line; std::getline(in, line);)
+        if (line.size() > 5)
+            lines.push_back(line);
+    if (lines.empty())
+        lines.push_back("0000 Goodmorning1");
+    long frames = argc > 2 ? std::atol(argv[2]) : 1000000;
+
+    std::vector<std::string> log(1);
+    size_t sink = 0;
+    long before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < frames; i++)
+        sink += legacyFrame(lines[i % lines.size()], log);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-8s %8.3f allocations/frame %8.1f ns/frame\n", "legacy",
+                (double)(allocations - before) / frames, ns / frames);
+
+    std::vector<std::string> messages;
+    messages.reserve(frames);
+    for (long i = 0; i < frames; i++)
+        messages.push_back(lines[i % lines.size()]);
+    ArqConfig config;
+    Loop loop;
+    LogSink logSink("/dev/null");
+    CountingHost sender(loop, 0, config, nullptr, logSink);
+    CountingHost receiver(loop, 1, config, &messages, logSink);
+    loop.hosts = {&sender, &receiver};
+    sender.arq.start(messages);
+
+    before = allocations;
+    long beforeHost = hostAllocations;
+    start = std::chrono::steady_clock::now();
+    loop.run();
+    ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    long sent = sender.dataFrames;
+    std::printf("%-8s %8.3f allocations/frame %8.1f ns/frame, %.3f in the endpoints, %ld of %ld delivered\n", "current",
+                (double)(allocations - before) / sent, ns / sent,
+                (double)(allocations - before - (hostAllocations - beforeHost)) / sent,
+                receiver.delivered, frames);
+
+    return sink == 0 || receiver.delivered != frames || receiver.mismatches != 0;
+}
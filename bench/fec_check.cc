@@ -0,0 +1,116 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+//
+// Single-bit errors on FEC-coded frames, as simulateErrors injects them.
+// Every line of the input is compressed against the lines before it (so
+// the frames hold LZ offset bytes such as 0x80), byte-stuffed and coded
+// with Hamming and with Reed-Solomon. Then every bit of every coded frame
+// is flipped in turn, and the damaged frame must neither contain '\0',
+// which would cut it short in M_Payload, nor fail to decode to the framed
+// payload. Exits with 1 on the first failure.
+//
+// Usage: fec_check [input file] [fecParity]
+//
+
+#include "Compression.h"
+#include "Fec.h"
+#include "Framing.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Decodes a coded frame the way the receiver sees it, through a C string
+bool check(const char *name, const std::string &coded, const std::string &framed, int parity, long &flips)
+{
+    for (size_t bit = 0; bit < 8 * coded.size(); bit++)
+    {
+        std::string damaged = coded;
+        damaged[bit / 8] ^= (char)(1 << (bit % 8));
+        if (std::strlen(damaged.c_str()) != damaged.size())
+        {
+            std::printf("%s: flipping bit %zu gives '\\0' at byte %zu\n", name, bit, bit / 8);
+            return false;
+        }
+
+        std::string received(damaged.c_str());
+        std::string decoded;
+        int corrected;
+        bool ok = parity > 0 ? rsDecode(received, parity, decoded, corrected)
+                             : hammingDecode(received, decoded, corrected);
+        if (!ok || decoded != framed)
+        {
+            std::printf("%s: flipping bit %zu is not repaired\n", name, bit);
+            return false;
+        }
+        flips++;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const char *input = argc > 1 ? argv[1] : "../simulations/input0.txt";
+    int parity = argc > 2 ? std::atoi(argv[2]) : 4;
+
+    std::ifstream file(input);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.size() > 5)
+            lines.push_back(line.substr(5)); // Without the error code
+    }
+    if (lines.empty())
+    {
+        std::fprintf(stderr, "No input lines in %s\n", input);
+        return 1;
+    }
+
+    // Twice over, so the second round compresses against the first
+    LzCodec codec;
+    long frames = 0, singleBitBytes = 0, hammingFlips = 0, rsFlips = 0;
+    for (int round = 0; round < 2; round++)
+    {
+        for (const std::string &message : lines)
+        {
+            std::string packed = codec.compress(message);
+            std::pmr::string stuffed;
+            byteStuff(packed, stuffed);
+            std::string framed(stuffed);
+            for (unsigned char c : framed)
+                singleBitBytes += c != 0 && (c & (c - 1)) == 0;
+
+            if (!check("hamming", hammingEncode(framed), framed, 0, hammingFlips) ||
+                !check("rs", rsEncode(framed, parity), framed, parity, rsFlips))
+                return 1;
+            frames++;
+        }
+    }
+
+    std::printf("%ld frames, %ld framed bytes with a single bit set\n", frames, singleBitBytes);
+    std::printf("%-8s %ld single-bit errors repaired\n", "hamming", hammingFlips);
+    std::printf("%-8s %ld single-bit errors repaired\n", "rs", rsFlips);
+    return 0;
+}
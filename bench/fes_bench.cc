@@ -0,0 +1,359 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+//
+// Event scheduling cost of the node's timers with many links and heavy
+// loss, the two ways Node can keep them (timerQueue):
+//
+//   fes       every retransmission timer is its own event in one indexed
+//             binary heap, like OMNeT++'s cEventHeap; a cancelled timer
+//             is removed from the heap. As in Node, each timer start
+//             allocates a fresh event named after its frame, deleted when
+//             it is cancelled or fires
+//   calendar  a node's timers sit in its CalendarQueue, and the heap holds
+//             one wakeup event per node, moved only when a timer comes
+//             due before it; a cancelled timer leaves the wakeup alone
+//
+// Each link runs a window of frames with one timer per frame; frames and
+// ACKs are lost with the given probability. Frame and ACK arrivals are
+// heap events in both cases. The simulated traffic is the same, only the
+// scheduling differs, so the cost is given per frame sent.
+//
+// Usage: fes_bench [loss] [frames]
+//
+
+#include "CalendarQueue.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int64_t SECOND = 1000000000000LL; // Picoseconds, OMNeT++'s default resolution
+const int WINDOW = 4;
+const int64_t TIMEOUT = 10 * SECOND;
+const int64_t PROCESSING = SECOND / 2;
+const int64_t PROPAGATION = SECOND;
+
+enum Kind
+{
+    FRAME,   // A frame reaches the receiver
+    ACK,     // Its ACK reaches the sender
+    TIMER,   // fes: a retransmission timer
+    WAKEUP   // calendar: a node's earliest timer is due
+};
+
+struct Event
+{
+    int64_t at;
+    uint64_t order;
+    Kind kind;
+    int link;
+    int slot;
+    int heapIndex = -1;
+    std::string name;
+};
+
+// Binary heap over pooled events, each knowing its position so it can be removed
+class EventHeap
+{
+public:
+    bool empty() const { return heap.empty(); }
+    size_t size() const { return heap.size(); }
+    Event *top() const { return heap[0]; }
+
+    void insert(Event *event)
+    {
+        event->heapIndex = heap.size();
+        heap.push_back(event);
+        up(event->heapIndex);
+    }
+
+    void remove(Event *event)
+    {
+        size_t i = event->heapIndex;
+        Event *last = heap.back();
+        heap.pop_back();
+        event->heapIndex = -1;
+        if (last == event)
+            return;
+        heap[i] = last;
+        last->heapIndex = i;
+        up(i);
+        down(last->heapIndex);
+    }
+
+    Event *removeFirst()
+    {
+        Event *first = heap[0];
+        remove(first);
+        return first;
+    }
+
+private:
+    std::vector<Event *> heap;
+
+    static bool earlier(const Event *a, const Event *b)
+    {
+        return a->at != b->at ? a->at < b->at : a->order < b->order;
+    }
+
+    void place(size_t i, Event *event)
+    {
+        heap[i] = event;
+        event->heapIndex = i;
+    }
+
+    void up(size_t i)
+    {
+        Event *event = heap[i];
+        while (i > 0 && earlier(event, heap[(i - 1) / 2]))
+        {
+            place(i, heap[(i - 1) / 2]);
+            i = (i - 1) / 2;
+        }
+        place(i, event);
+    }
+
+    void down(size_t i)
+    {
+        Event *event = heap[i];
+        for (;;)
+        {
+            size_t child = 2 * i + 1;
+            if (child >= heap.size())
+                break;
+            if (child + 1 < heap.size() && earlier(heap[child + 1], heap[child]))
+                child++;
+            if (!earlier(heap[child], event))
+                break;
+            place(i, heap[child]);
+            i = child;
+        }
+        place(i, event);
+    }
+};
+
+struct CalendarTimer
+{
+    int64_t at;
+    uint64_t order;
+    int slot;
+};
+
+struct Link
+{
+    Event *timers[WINDOW] = {};        // fes
+    CalendarTimer pending[WINDOW];     // calendar: each slot's running timer
+    bool running[WINDOW] = {};
+    CalendarQueue<CalendarTimer> calendar;
+    Event *wakeup = nullptr;
+};
+
+class Simulation
+{
+public:
+    Simulation(int links, double loss, bool calendar)
+        : links(links), loss(loss), useCalendar(calendar), rng(1) {}
+
+    double run(long frames, long &timeouts, size_t &peakHeap)
+    {
+        // Every link opens its window at a random offset in the first second
+        std::uniform_int_distribution<int64_t> offset(0, SECOND);
+        for (int l = 0; l < (int)links.size(); l++)
+        {
+            now = offset(rng);
+            for (int slot = 0; slot < WINDOW; slot++)
+                sendFrame(l, slot);
+        }
+        now = 0;
+        sent = 0;
+        timeouts = 0;
+        peakHeap = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        while (sent < frames && !heap.empty())
+        {
+            peakHeap = std::max(peakHeap, heap.size());
+            Event *event = heap.removeFirst();
+            now = event->at;
+            Link &link = links[event->link];
+            switch (event->kind)
+            {
+            case FRAME:
+                if (!lost())
+                    schedule(ACK, now + PROCESSING + jitter(), event->link, event->slot);
+                break;
+            case ACK:
+                // The slot's frame is acknowledged: stop its timer and send the next one
+                stopTimer(event->link, event->slot);
+                sendFrame(event->link, event->slot);
+                break;
+            case TIMER:
+                link.timers[event->slot] = nullptr;
+                timeouts++;
+                sendFrame(event->link, event->slot);
+                delete event;
+                continue;
+            case WAKEUP:
+                link.wakeup = nullptr;
+                while (!link.calendar.empty() && link.calendar.top().at <= now)
+                {
+                    int slot = link.calendar.top().slot;
+                    link.calendar.pop();
+                    link.running[slot] = false;
+                    timeouts++;
+                    sendFrame(event->link, slot);
+                }
+                rescheduleWakeup(event->link);
+                break;
+            }
+            pool.push_back(event);
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::vector<Link> links;
+    double loss;
+    bool useCalendar;
+    std::mt19937_64 rng;
+    EventHeap heap;
+    std::vector<Event *> pool;
+    std::vector<std::unique_ptr<Event>> storage;
+    int64_t now = 0;
+    uint64_t order = 0;
+    long sent = 0;
+
+    bool lost() { return std::uniform_real_distribution<double>(0, 1)(rng) < loss; }
+    int64_t jitter() { return std::uniform_int_distribution<int64_t>(0, SECOND / 10)(rng); }
+
+    Event *schedule(Kind kind, int64_t at, int link, int slot)
+    {
+        Event *event;
+        if (pool.empty())
+        {
+            storage.emplace_back(new Event());
+            event = storage.back().get();
+        }
+        else
+        {
+            event = pool.back();
+            pool.pop_back();
+        }
+        event->at = at;
+        event->order = order++;
+        event->kind = kind;
+        event->link = link;
+        event->slot = slot;
+        heap.insert(event);
+        return event;
+    }
+
+    void sendFrame(int l, int slot)
+    {
+        sent++;
+        if (!lost())
+            schedule(FRAME, now + PROCESSING + PROPAGATION + jitter(), l, slot);
+        startTimer(l, slot, now + PROCESSING + TIMEOUT);
+    }
+
+    void startTimer(int l, int slot, int64_t at)
+    {
+        Link &link = links[l];
+        if (!useCalendar)
+        {
+            stopTimer(l, slot);
+            Event *timer = new Event();
+            timer->name = std::to_string(slot);
+            timer->at = at;
+            timer->order = order++;
+            timer->kind = TIMER;
+            timer->link = l;
+            timer->slot = slot;
+            heap.insert(timer);
+            link.timers[slot] = timer;
+            return;
+        }
+        stopTimer(l, slot);
+        link.pending[slot] = CalendarTimer{at, order++, slot};
+        link.running[slot] = true;
+        link.calendar.push(link.pending[slot]);
+        if (!link.wakeup || at < link.wakeup->at)
+            rescheduleWakeup(l);
+    }
+
+    void stopTimer(int l, int slot)
+    {
+        Link &link = links[l];
+        if (useCalendar)
+        {
+            if (link.running[slot])
+                link.calendar.remove(link.pending[slot]);
+            link.running[slot] = false;
+        }
+        else if (link.timers[slot])
+        {
+            heap.remove(link.timers[slot]);
+            delete link.timers[slot];
+            link.timers[slot] = nullptr;
+        }
+    }
+
+    void rescheduleWakeup(int l)
+    {
+        Link &link = links[l];
+        int64_t at = link.calendar.empty() ? -1 : link.calendar.top().at;
+        if (link.wakeup && link.wakeup->at == at)
+            return;
+        if (link.wakeup)
+        {
+            heap.remove(link.wakeup);
+            pool.push_back(link.wakeup);
+            link.wakeup = nullptr;
+        }
+        if (at >= 0)
+            link.wakeup = schedule(WAKEUP, at, l, 0);
+    }
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    double loss = argc > 1 ? std::atof(argv[1]) : 0.3;
+    long frames = argc > 2 ? std::atol(argv[2]) : 2000000;
+
+    std::printf("loss %.2f, window %d, %ld frames per run\n", loss, WINDOW, frames);
+    std::printf("%8s %-9s %10s %10s %12s\n", "links", "timers", "ns/frame", "peak FES", "timeouts");
+    for (int links : {10, 100, 1000, 10000, 100000})
+    {
+        for (bool calendar : {false, true})
+        {
+            Simulation simulation(links, loss, calendar);
+            long timeouts;
+            size_t peak;
+            double ns = simulation.run(frames, timeouts, peak);
+            std::printf("%8d %-9s %10.1f %10zu %12ld\n", links, calendar ? "calendar" : "fes",
+                        ns / frames, peak, timeouts);
+        }
+    }
+    return 0;
+}
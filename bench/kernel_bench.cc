@@ -0,0 +1,190 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+//
+// Per-call cost of the frame kernels the ARQ core runs on every frame:
+// byteStuff, byteUnstuff, the fused byteUnstuffCrc, the CRC-8 over a frame
+// (computeCRC / checkCRC) and the bit-flip path of simulateErrors, which
+// copies the wire payload into the event arena and flips one bit.
+//
+// Each kernel runs over payload sizes from 16 bytes to 16 KB and over
+// flag densities from none to all bytes being '$' or '/', and reports
+// ns/call, ns/byte of payload and heap allocations per call (every
+// operator new is counted).
+//
+// Usage: kernel_bench [milliseconds per case]
+//
+
+#include "Crc.h"
+#include "Framing.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory_resource>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+static long allocations = 0;
+
+void *operator new(std::size_t size)
+{
+    allocations++;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+// An arena that outgrows its buffer takes memory from upstream through these
+void *operator new(std::size_t size, std::align_val_t align)
+{
+    allocations++;
+    if (void *p = std::aligned_alloc((std::size_t)align, (size + (std::size_t)align - 1) & ~((std::size_t)align - 1)))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+// Printable payload in which a fraction of the bytes are flags or escapes
+std::string makePayload(size_t size, double flagDensity, std::mt19937 &rng)
+{
+    std::uniform_real_distribution<double> coin(0, 1);
+    std::uniform_int_distribution<int> printable('A', 'z');
+    std::string payload(size, ' ');
+    for (char &c : payload)
+        c = coin(rng) < flagDensity ? (coin(rng) < 0.5 ? '$' : '/') : (char)printable(rng);
+    return payload;
+}
+
+struct Result
+{
+    double nsPerCall;
+    double allocationsPerCall;
+};
+
+// Runs kernel for about budget milliseconds, in batches so the clock is read rarely
+template <typename Kernel>
+Result measure(double budget, Kernel &&kernel)
+{
+    long calls = 0;
+    long before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    for (long batch = 1; elapsed < budget * 1e6; batch *= 2)
+    {
+        for (long i = 0; i < batch; i++)
+            kernel();
+        calls += batch;
+        elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+    return Result{elapsed / calls, (double)(allocations - before) / calls};
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    double budget = argc > 1 ? std::atof(argv[1]) : 20;
+
+    const size_t sizes[] = {16, 64, 256, 1024, 4096, 16384};
+    const double densities[] = {0, 0.1, 0.5, 1};
+
+    alignas(std::max_align_t) static char buffer[16 * 1024];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+    std::mt19937 rng(1);
+    std::string unstuffed;
+    volatile unsigned sink = 0;
+
+    std::printf("%-16s %7s %6s %12s %9s %12s\n", "kernel", "bytes", "flags", "ns/call", "ns/byte", "allocs/call");
+    for (double density : densities)
+    {
+        for (size_t size : sizes)
+        {
+            std::string payload = makePayload(size, density, rng);
+            std::pmr::string framedArena(&arena);
+            byteStuff(payload, framedArena);
+            std::string framed(framedArena);
+            char crc = (char)crc8Update(CRC8_INIT, framed.data(), framed.size());
+            arena.release();
+
+            auto report = [&](const char *name, const Result &r) {
+                std::printf("%-16s %7zu %5.0f%% %12.1f %9.3f %12.2f\n", name, size, 100 * density,
+                            r.nsPerCall, r.nsPerCall / size, r.allocationsPerCall);
+            };
+
+            // Sender: frame into the arena, as buildDataFrame() does
+            report("byteStuff", measure(budget, [&] {
+                std::pmr::string out(&arena);
+                byteStuff(payload, out);
+                sink = sink + out.size();
+                arena.release();
+            }));
+
+            // Receiver, general path: into a reused buffer
+            report("byteUnstuff", measure(budget, [&] {
+                sink = sink + byteUnstuff(framed, unstuffed);
+            }));
+
+            // Receiver fast path: unstuffing and CRC in one pass
+            report("byteUnstuffCrc", measure(budget, [&] {
+                uint8_t calculated;
+                sink = sink + byteUnstuffCrc(framed.c_str(), unstuffed, calculated) + calculated;
+            }));
+
+            // computeCRC(): CRC-8 of the framed payload
+            report("computeCRC", measure(budget, [&] {
+                sink = sink + crc8Update(CRC8_INIT, framed.data(), framed.size());
+            }));
+
+            // checkCRC(): recompute and compare with the trailer
+            report("checkCRC", measure(budget, [&] {
+                sink = sink + (crc8Update(CRC8_INIT, framed.data(), framed.size()) == (uint8_t)crc);
+            }));
+
+            // simulateErrors(), modification cases: arena copy of the wire payload and one bit flip
+            report("simulateErrors", measure(budget, [&] {
+                std::pmr::string copy(framed.c_str(), &arena);
+                int bitPosition = rand() % (copy.length() * 8);
+                copy[bitPosition / 8] ^= (1 << (bitPosition % 8));
+                sink = sink + (unsigned char)copy[bitPosition / 8];
+                arena.release();
+            }));
+        }
+    }
+    return sink == 0xFFFFFFFF;
+}
@@ -0,0 +1,1136 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+#include "Arq.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <stdexcept>
+
+ArqEndpoint::ArqEndpoint(const ArqConfig &config, ArqClock &clock, ArqTransport &transport)
+    : config(config), clock(clock), transport(transport), frameArena(arenaBuffer, sizeof(arenaBuffer))
+{
+    // Sequence numbers run 0..maxSeqNumber; selective repeat needs WS <= (SN + 1) / 2
+    seqSpace = config.maxSeqNumber + 1;
+    if (config.windowSize < 1 || config.windowSize > seqSpace / 2)
+        throw std::invalid_argument("windowSize=" + std::to_string(config.windowSize) +
+                                    " is too large for maxSeqNumber=" + std::to_string(config.maxSeqNumber));
+    // The SACK bitmap is an int with one bit per frame after the ACK
+    if (config.selectiveAck && config.windowSize > 32)
+        throw std::invalid_argument("windowSize=" + std::to_string(config.windowSize) +
+                                    " exceeds the 32 frames a SACK bitmap covers");
+    if ((config.aggregation || config.fragmentation) && config.mtu <= 0)
+        throw std::invalid_argument("mtu must be positive for aggregation and fragmentation");
+    if (config.fecMode == FEC_REED_SOLOMON &&
+        (config.fecParity < 2 || config.fecParity % 2 != 0 || config.fecParity > 128))
+        throw std::invalid_argument("fecParity must be an even number between 2 and 128");
+    if (config.deliveryQueue < 0)
+        throw std::invalid_argument("deliveryQueue must not be negative");
+
+    // Fragments reach reassembly in order after ARQ, so the next one may
+    // still be due after a window of retransmissions at the largest RTO;
+    // a shorter reassemblyTimeout drops messages ARQ would have delivered
+    double maxRto = std::max(config.timeoutInterval, config.adaptiveTimeout ? config.maxTimeout : 0);
+    if (config.fragmentation && config.reassemblyTimeout > 0 &&
+        config.reassemblyTimeout <= maxRto * (config.windowSize + 1))
+    {
+        char text[128];
+        snprintf(text, sizeof(text), "reassemblyTimeout=%g must be 0 or exceed the largest RTO times windowSize + 1 (%g)",
+                 config.reassemblyTimeout, maxRto * (config.windowSize + 1));
+        throw std::invalid_argument(text);
+    }
+
+    expectedFrameToReceive = 0;
+    baseIndex = 0;
+    currentIndex = 0;
+    nextMessage = 0;
+    senderWindow.resize(seqSpace);
+    receiverBuffer.resize(seqSpace);
+    frameReceived.resize(seqSpace, false);
+    ackReceived.resize(seqSpace, false);
+
+    rto = config.timeoutInterval;
+    srtt = 0;
+    rttvar = 0;
+    hasRttSample = false;
+    sendTimes.resize(seqSpace);
+    retransmitted.resize(seqSpace, false);
+
+    sacked.resize(seqSpace, false);
+    lastSendTimes.resize(seqSpace);
+
+    nextFragment = 0;
+    reassemblyFragments = 0;
+    reassemblyPending = false;
+
+    unackedFrames = 0;
+    ackPending = false;
+
+    queuedFrames = 0;
+    advertisedCredit = -1;
+    sendLimit = INT_MAX;
+}
+
+void ArqEndpoint::start(std::vector<std::string> lines)
+{
+    // With lines still unsent a send is already scheduled or waits for an
+    // ACK; sending now as well would start a second chain of sends
+    bool sending = nextMessage < (int)messages.size();
+    queue(std::move(lines));
+    if (!sending)
+        sendFrames();
+}
+
+void ArqEndpoint::queue(std::vector<std::string> lines)
+{
+    if (messages.empty())
+        messages = std::move(lines);
+    else
+        messages.insert(messages.end(), std::make_move_iterator(lines.begin()), std::make_move_iterator(lines.end()));
+}
+
+void ArqEndpoint::receive(const ArqFrame &frame)
+{
+    switch (frame.type)
+    {
+    case FRAME_ACK:
+    case FRAME_SACK:
+    case FRAME_NACK:
+        handleAck(frame);
+        break;
+    case FRAME_DATA:
+    case FRAME_AGGREGATE:
+        receiveFrame(frame);
+        break;
+    }
+    endEvent();
+}
+
+bool ArqEndpoint::windowOpen() const
+{
+    return nextMessage < (int)messages.size() &&
+           currentIndex < baseIndex + config.windowSize &&
+           !ackReceived[currentIndex % seqSpace];
+}
+
+bool ArqEndpoint::readyToSend() const
+{
+    return windowOpen() && (currentIndex < sendLimit || currentIndex == baseIndex);
+}
+
+void ArqEndpoint::sendFrames()
+{
+    bool canSend = windowOpen();
+
+    // Beyond the peer's credit only a lone probe may go, so that a lost
+    // window update cannot stall the link: its retransmission timer asks
+    // again until the receiver has room
+    if (canSend && currentIndex >= sendLimit && currentIndex > baseIndex)
+    {
+        counters.creditStalls++;
+        canSend = false;
+    }
+
+    if (canSend)
+    {
+        const std::string &message = messages[nextMessage];
+        std::string_view data = std::string_view(message).substr(5); // Skip error code
+
+        // An aggregate frame takes the error code of its first message
+        std::string errorCode = message.substr(0, 4);
+
+        int slot = currentIndex % seqSpace;
+        SentFrame &sent = senderWindow[slot];
+        sent.type = FRAME_DATA;
+        sent.fragIndex = 0;
+        sent.lastFragment = true;
+
+        int mtu = config.mtu;
+        if (config.fragmentation && (nextFragment > 0 || (int)data.size() > mtu))
+        {
+            sent.payload.assign(data.substr(nextFragment * mtu, mtu));
+            sent.fragIndex = nextFragment;
+            sent.lastFragment = (nextFragment + 1) * mtu >= (int)data.size();
+
+            // The line's channel error hits only its first fragment
+            if (nextFragment > 0)
+                errorCode = "0000";
+
+            if (sent.lastFragment)
+            {
+                nextMessage++;
+                nextFragment = 0;
+            }
+            else
+            {
+                nextFragment++;
+            }
+            counters.fragmentsSent++;
+        }
+        else if (config.aggregation)
+        {
+            aggregateMessages(sent.payload);
+            sent.type = FRAME_AGGREGATE;
+        }
+        else
+        {
+            sent.payload.assign(data);
+            nextMessage++;
+        }
+
+        sent.compressed = false;
+        if (config.compression)
+            sent.payload = compressPayload(sent.payload, sent.compressed);
+        sent.wire.clear(); // New payload, framed on first transmission
+
+        ArqFrame frame;
+        buildDataFrame(currentIndex, "DataFrame", frame);
+
+        logEvent(LogRecord::CHANNEL_ERROR, 0, errorCode);
+
+        // Update window state
+        sendTimes[slot] = clock.now();
+        lastSendTimes[slot] = sendTimes[slot];
+        sacked[slot] = false;
+        retransmitted[slot] = false;
+        startTimer(currentIndex);
+
+        simulateErrors(frame, errorCode);
+        currentIndex++;
+
+        // Schedule next frame after processing delay
+        if (nextMessage < (int)messages.size())
+            clock.scheduleSend(config.processingTime);
+    }
+    endEvent();
+}
+
+void ArqEndpoint::buildDataFrame(int index, const char *name, ArqFrame &frame)
+{
+    SentFrame &sent = senderWindow[index % seqSpace];
+
+    // Frame and checksum the payload once; retransmissions reuse the result.
+    // The CRC covers the framed payload only, so the header fields that do
+    // change between copies (piggybacked ACK and SACK) leave it valid.
+    if (sent.wire.empty())
+    {
+        size_t framedBits;
+        std::pmr::string framedPayload(&frameArena);
+        encodeFrame(sent.payload, framedBits, framedPayload);
+        sent.crc = computeCRC(framedPayload);
+        fecEncode(framedPayload, sent.wire);
+        sent.lineBits = framedBits + 8 * (sent.wire.size() - framedPayload.size());
+    }
+    else
+    {
+        counters.reusedFrames++;
+    }
+
+    frame.name = name;
+    frame.type = sent.type;
+    frame.seqNum = index % seqSpace;
+    frame.payload = sent.wire.c_str();
+    frame.trailer = sent.crc;
+    frame.compressed = sent.compressed;
+    frame.bitLength = sent.lineBits + 16; // Header + payload + trailer
+    if (sent.fragIndex > 0 || !sent.lastFragment)
+    {
+        frame.fragIndex = sent.fragIndex;
+        frame.lastFragment = sent.lastFragment;
+        frame.bitLength += 8; // Fragment header
+    }
+    attachAck(frame);
+}
+
+int ArqEndpoint::unwrapSeqNum(int seqNum, int reference) const
+{
+    // Map a wire sequence number to the first absolute index >= reference with that value
+    int offset = ((seqNum - reference) % seqSpace + seqSpace) % seqSpace;
+    return reference + offset;
+}
+
+void ArqEndpoint::startTimer(int index)
+{
+    clock.startTimer(TIMER_RETRANSMIT, index, config.adaptiveTimeout ? rto : config.timeoutInterval);
+}
+
+void ArqEndpoint::stopTimer(int index)
+{
+    clock.cancelTimer(TIMER_RETRANSMIT, index);
+}
+
+void ArqEndpoint::updateRtt(double r)
+{
+    // RFC 6298 section 2 with alpha = 1/8, beta = 1/4, K = 4
+    if (!hasRttSample)
+    {
+        srtt = r;
+        rttvar = r / 2;
+        hasRttSample = true;
+    }
+    else
+    {
+        rttvar = 0.75 * rttvar + 0.25 * std::fabs(srtt - r);
+        srtt = 0.875 * srtt + 0.125 * r;
+    }
+    rto = std::min(std::max(srtt + 4 * rttvar, config.minTimeout), config.maxTimeout);
+
+    transport.rttSample(r);
+    transport.rtoChanged(rto);
+}
+
+void ArqEndpoint::handleAck(const ArqFrame &frame)
+{
+    if (frame.type == FRAME_NACK)
+    {
+        int ackNum = unwrapSeqNum(frame.seqNum, baseIndex);
+        if (ackNum >= baseIndex && ackNum < currentIndex)
+            retransmitFrame(ackNum);
+    }
+    else
+    {
+        processAck(frame.seqNum, frame.sack, frame.credit);
+    }
+}
+
+void ArqEndpoint::retransmitFrame(int index)
+{
+    int slot = index % seqSpace;
+
+    ArqFrame frame;
+    buildDataFrame(index, "RetransFrame", frame);
+    transport.transmit(frame, config.processingTime);
+
+    // Karn: no RTT sample may be taken from this frame any more
+    retransmitted[slot] = true;
+    lastSendTimes[slot] = clock.now();
+    counters.retransmissions++;
+    startTimer(index);
+}
+
+void ArqEndpoint::processAck(int ackSeqNum, int sackBitmap, int peerCredit)
+{
+    // Cumulative ACK: ackNum is the next frame the receiver expects
+    int ackNum = unwrapSeqNum(ackSeqNum, baseIndex);
+    bool slid = ackNum > baseIndex && ackNum <= currentIndex;
+    if (slid)
+    {
+        // Karn: only sample frames that were sent exactly once
+        int newest = (ackNum - 1) % seqSpace;
+        if (!retransmitted[newest])
+            updateRtt(clock.toSeconds(clock.now() - sendTimes[newest]));
+
+        // Clear all acknowledged frames
+        for (int i = baseIndex; i < ackNum; i++)
+        {
+            stopTimer(i);
+            ackReceived[i % seqSpace] = false;
+            sacked[i % seqSpace] = false;
+            senderWindow[i % seqSpace].payload.clear();
+            senderWindow[i % seqSpace].wire.clear();
+        }
+
+        // Slide window
+        baseIndex = ackNum;
+
+        // Try sending new frames
+        clock.scheduleSend(config.processingTime);
+    }
+
+    // The receiver can take peerCredit frames from ackNum on; a larger credit
+    // on an ACK that slides nothing is a window update
+    if (peerCredit >= 0 && ackNum >= baseIndex && ackNum <= currentIndex)
+    {
+        int limit = ackNum + peerCredit;
+        if (limit > sendLimit && !slid && nextMessage < (int)messages.size())
+            clock.scheduleSend(config.processingTime);
+        sendLimit = limit;
+    }
+
+    if (config.selectiveAck && sackBitmap != 0 && ackNum == baseIndex)
+        processSack(sackBitmap);
+}
+
+void ArqEndpoint::processSack(int sackBitmap)
+{
+    // Bit i reports frame baseIndex + 1 + i as buffered at the receiver
+    int highestSacked = baseIndex;
+    for (int i = 0; i < config.windowSize - 1; i++)
+    {
+        int index = baseIndex + 1 + i;
+        if (index >= currentIndex)
+            break;
+        if (sackBitmap & (1 << i))
+        {
+            sacked[index % seqSpace] = true;
+            stopTimer(index);
+            highestSacked = index;
+        }
+    }
+
+    // Every unreported frame below the highest SACKed one is a gap; resend
+    // them all at once, but not again before a round trip has passed
+    ArqTime holdoff = clock.fromSeconds(hasRttSample ? srtt : rto);
+    for (int index = baseIndex; index < highestSacked; index++)
+    {
+        int slot = index % seqSpace;
+        if (!sacked[slot] && clock.now() - lastSendTimes[slot] >= holdoff)
+        {
+            retransmitFrame(index);
+            counters.sackRetransmissions++;
+        }
+    }
+}
+
+void ArqEndpoint::receiveFrame(const ArqFrame &frame)
+{
+    int rcvSeqNum = frame.seqNum;
+
+    // Position of the frame relative to the receive window
+    int rcvIndex = unwrapSeqNum(rcvSeqNum, expectedFrameToReceive);
+
+    // Decode straight into the receive slot while it is free; a copy of a
+    // frame that is already buffered goes to scratch space so that a damaged
+    // duplicate cannot clobber it
+    int slot = rcvIndex % seqSpace;
+    bool slotFree = rcvIndex < expectedFrameToReceive + config.windowSize && !frameReceived[slot];
+    std::string &data = slotFree ? receiverBuffer[slot].payload : rxScratch;
+    bool crcValid = decodeReceived(frame.payload, frame.trailer, data);
+
+    // Subframe CRCs of an aggregate must hold as well; a compressed
+    // aggregate can only be expanded in order, at delivery
+    bool isAggregate = frame.type == FRAME_AGGREGATE;
+    if (crcValid && isAggregate && !frame.compressed && !deaggregate(data, subframes))
+    {
+        transport.note("Malformed aggregate or subframe CRC error");
+        crcValid = false;
+    }
+
+    // Piggybacked ACK for our own outgoing frames
+    if (crcValid && frame.ack >= 0)
+        processAck(frame.ack, frame.sack, frame.credit);
+
+    // Check if frame is within window bounds
+    if (rcvIndex < expectedFrameToReceive + config.windowSize)
+    {
+        if (crcValid)
+        {
+            // Buffer the frame
+            ReceivedFrame &buffered = receiverBuffer[slot];
+            if (!slotFree)
+                buffered.payload.swap(data);
+            buffered.aggregate = isAggregate;
+            buffered.compressed = frame.compressed;
+            buffered.fragIndex = frame.fragIndex;
+            buffered.lastFragment = frame.lastFragment;
+            frameReceived[slot] = true;
+
+            // Deliver everything that is now in order
+            int delivered = deliverInOrder();
+
+            // Send cumulative ACK for highest consecutive frame
+            if (delivered > 0)
+            {
+                // A frame that closed a gap is acknowledged right away
+                scheduleAck(delivered > 1);
+            }
+            else
+            {
+                // Out-of-order frame: report the gap immediately
+                scheduleAck(true);
+            }
+        }
+        else
+        {
+            transport.note("Invalid CRC");
+
+            // NACK the damaged frame
+            ArqFrame nack;
+            nack.name = "NACK";
+            nack.type = FRAME_NACK;
+            nack.seqNum = rcvSeqNum;
+            nack.bitLength = 16;
+            transport.transmit(nack, config.processingTime);
+
+            logLater(LogRecord::NACK, rcvSeqNum, config.processingTime);
+        }
+    }
+    else
+    {
+        // Frame was already delivered (duplicate, or retransmitted after
+        // a lost ACK): acknowledge again so the sender can slide its window
+        scheduleAck(true);
+    }
+}
+
+int ArqEndpoint::deliverInOrder()
+{
+    // With flow control, frames wait in the receive buffer while the
+    // backlog is full
+    int highestConsecutive = expectedFrameToReceive;
+    while (frameReceived[highestConsecutive % seqSpace] &&
+           (config.deliveryQueue == 0 || queuedFrames < config.deliveryQueue))
+    {
+        int deliverSlot = highestConsecutive % seqSpace;
+        ReceivedFrame &rf = receiverBuffer[deliverSlot];
+        // The frame passed its CRC and the sender's dictionary already holds
+        // it; dropping it here would leave every later frame decoding against
+        // the wrong history, so the session cannot go on
+        if (config.compression && !decompressPayload(rf))
+            throw std::runtime_error("Decompression of frame " + std::to_string(deliverSlot) +
+                                     " failed, the compression dictionaries are out of step");
+
+        if (rf.aggregate)
+        {
+            deaggregate(rf.payload, subframes);
+        }
+        else if (rf.fragIndex > 0 || !rf.lastFragment)
+        {
+            // Only a completed message goes up to the network layer
+            subframes.clear();
+            std::string message;
+            if (reassemble(rf, message))
+                subframes.push_back(message);
+        }
+        else
+        {
+            subframes.assign(1, rf.payload);
+        }
+
+        if (config.deliveryQueue == 0)
+        {
+            for (const std::string &message : subframes)
+                transport.deliver(message, deliverSlot);
+        }
+        else if (!subframes.empty())
+        {
+            for (std::string &message : subframes)
+                backlog.push_back(QueuedMessage{std::move(message), deliverSlot, false});
+            backlog.back().lastOfFrame = true;
+            queuedFrames++;
+        }
+
+        // Clear buffer and mark as unreceived
+        rf.payload.clear();
+        frameReceived[deliverSlot] = false;
+        highestConsecutive++;
+    }
+
+    int delivered = highestConsecutive - expectedFrameToReceive;
+    expectedFrameToReceive = highestConsecutive;
+    counters.framesDelivered += delivered;
+    unackedFrames += delivered;
+    return delivered;
+}
+
+int ArqEndpoint::credit() const
+{
+    if (config.deliveryQueue == 0)
+        return -1;
+    return std::min(std::max(config.deliveryQueue - queuedFrames, 0), config.windowSize);
+}
+
+void ArqEndpoint::consume()
+{
+    if (backlog.empty())
+        return;
+
+    QueuedMessage &message = backlog.front();
+    transport.deliver(message.data, message.seqNum);
+    if (message.lastOfFrame)
+        queuedFrames--;
+    backlog.pop_front();
+
+    // Frames held back for lack of room move up now; the sender hears of
+    // them, or of the room alone if it was told there was none
+    if (deliverInOrder() > 0 || (advertisedCredit == 0 && credit() > 0))
+    {
+        counters.windowUpdates++;
+        sendAck(expectedFrameToReceive);
+    }
+    endEvent();
+}
+
+void ArqEndpoint::scheduleAck(bool immediate)
+{
+    bool delayedAcks = config.piggybackAcks || config.ackEvery > 0;
+    if (immediate || !delayedAcks || config.ackDelay <= 0 ||
+        (config.ackEvery > 0 && unackedFrames >= config.ackEvery))
+    {
+        sendAck(expectedFrameToReceive);
+        return;
+    }
+
+    // Coalesce: hold the ACK until ackEvery frames are delivered, a reverse
+    // data frame can carry it, or ackDelay expires - whichever comes first
+    if (!ackPending)
+    {
+        clock.startTimer(TIMER_ACK, 0, config.ackDelay);
+        ackPending = true;
+    }
+}
+
+void ArqEndpoint::attachAck(ArqFrame &frame)
+{
+    if (!ackPending)
+        return;
+
+    clock.cancelTimer(TIMER_ACK, 0);
+    ackPending = false;
+    unackedFrames = 0;
+    frame.ack = expectedFrameToReceive % seqSpace;
+    frame.bitLength += 8;
+    frame.credit = advertisedCredit = credit();
+    if (frame.credit >= 0)
+        frame.bitLength += 8;
+    if (config.selectiveAck)
+    {
+        frame.sack = buildSackBitmap();
+        frame.bitLength += 8;
+    }
+    counters.piggybackedAcks++;
+}
+
+int ArqEndpoint::buildSackBitmap() const
+{
+    int bitmap = 0;
+    for (int i = 1; i < config.windowSize; i++)
+    {
+        if (frameReceived[(expectedFrameToReceive + i) % seqSpace])
+            bitmap |= 1 << (i - 1);
+    }
+    return bitmap;
+}
+
+void ArqEndpoint::ackTimeout()
+{
+    // No data frame came along to carry the ACK in time
+    ackPending = false;
+    sendAck(expectedFrameToReceive);
+    endEvent();
+}
+
+void ArqEndpoint::sendAck(int nextExpected)
+{
+    if (ackPending)
+    {
+        clock.cancelTimer(TIMER_ACK, 0);
+        ackPending = false;
+    }
+    unackedFrames = 0;
+    counters.standaloneAcks++;
+
+    ArqFrame ack;
+    ack.name = "ACK";
+    ack.type = FRAME_ACK;
+    ack.seqNum = nextExpected % seqSpace; // ACK all frames up to this
+    ack.bitLength = 16;
+    ack.credit = advertisedCredit = credit();
+    if (ack.credit >= 0)
+        ack.bitLength += 8;
+
+    // Report frames buffered beyond the gap so the sender can repair all holes
+    int sackBitmap = config.selectiveAck ? buildSackBitmap() : 0;
+    if (sackBitmap != 0)
+    {
+        ack.name = "SACK";
+        ack.type = FRAME_SACK;
+        ack.sack = sackBitmap;
+        ack.bitLength += 8;
+    }
+    transport.transmit(ack, config.processingTime);
+
+    logLater(LogRecord::ACK, nextExpected % seqSpace, config.processingTime);
+}
+
+void ArqEndpoint::aggregateMessages(std::string &packed)
+{
+    // Subframe: "<length>:<data>" plus two hex digits of CRC-8 if enabled
+    packed.clear();
+    std::pmr::string subframe(&frameArena);
+    int count = 0;
+    while (nextMessage < (int)messages.size())
+    {
+        std::string_view data = std::string_view(messages[nextMessage]).substr(5);
+        subframe.assign(std::to_string(data.size()));
+        subframe += ':';
+        subframe += data;
+        if (config.subframeCrc)
+        {
+            static const char hex[] = "0123456789ABCDEF";
+            unsigned char c = computeCRC(data);
+            subframe += hex[c >> 4];
+            subframe += hex[c & 0x0F];
+        }
+
+        // Always take one message, even if it alone exceeds the MTU;
+        // with fragmentation an oversized message goes out in fragments
+        if (count > 0 && (packed.size() + subframe.size() > (size_t)config.mtu ||
+                          (config.fragmentation && (int)data.size() > config.mtu)))
+            break;
+        packed += subframe;
+        nextMessage++;
+        count++;
+    }
+    counters.aggregatedMessages += count;
+    counters.aggregateFrames++;
+}
+
+bool ArqEndpoint::deaggregate(const std::string &packed, std::vector<std::string> &subframes)
+{
+    subframes.clear();
+    size_t pos = 0;
+    while (pos < packed.size())
+    {
+        size_t colon = packed.find(':', pos);
+        if (colon == std::string::npos || colon == pos)
+            return false;
+
+        size_t len = 0;
+        for (size_t i = pos; i < colon; i++)
+        {
+            if (packed[i] < '0' || packed[i] > '9')
+                return false;
+            len = len * 10 + (packed[i] - '0');
+        }
+
+        size_t end = colon + 1 + len + (config.subframeCrc ? 2 : 0);
+        if (end > packed.size())
+            return false;
+
+        std::string data = packed.substr(colon + 1, len);
+        if (config.subframeCrc)
+        {
+            unsigned char c = computeCRC(data);
+            unsigned long received = std::strtoul(packed.substr(colon + 1 + len, 2).c_str(), nullptr, 16);
+            if (received != c)
+                return false;
+        }
+        subframes.push_back(data);
+        pos = end;
+    }
+    return !subframes.empty();
+}
+
+bool ArqEndpoint::reassemble(const ReceivedFrame &fragment, std::string &message)
+{
+    if (fragment.fragIndex == 0)
+    {
+        if (reassemblyFragments > 0)
+            evictReassembly("superseded by a new message");
+    }
+    else if (fragment.fragIndex != reassemblyFragments)
+    {
+        // Start of the message was evicted, the rest cannot be completed
+        if (reassemblyFragments > 0)
+            evictReassembly("fragment out of sequence");
+        counters.droppedFragments++;
+        return false;
+    }
+
+    if (reassemblyBuffer.size() + fragment.payload.size() > (size_t)config.maxReassemblyBytes)
+    {
+        evictReassembly("reassembly buffer full");
+        counters.droppedFragments++;
+        return false;
+    }
+
+    reassemblyBuffer += fragment.payload;
+    reassemblyFragments++;
+    if (!fragment.lastFragment)
+    {
+        // The timer bounds the wait for the next fragment, not for the whole
+        // message, which at a small MTU takes many round trips
+        if (config.reassemblyTimeout > 0)
+        {
+            clock.startTimer(TIMER_REASSEMBLY, 0, config.reassemblyTimeout);
+            reassemblyPending = true;
+        }
+        return false;
+    }
+
+    message.swap(reassemblyBuffer);
+    reassemblyBuffer.clear();
+    reassemblyFragments = 0;
+    if (reassemblyPending)
+        clock.cancelTimer(TIMER_REASSEMBLY, 0);
+    reassemblyPending = false;
+    counters.reassembledMessages++;
+    return true;
+}
+
+void ArqEndpoint::reassemblyTimeout()
+{
+    reassemblyPending = false;
+    evictReassembly("reassembly timeout");
+    endEvent();
+}
+
+void ArqEndpoint::evictReassembly(const char *reason)
+{
+    std::string text = "Dropping partial message of " + std::to_string(reassemblyFragments) +
+                       " fragment(s): " + reason;
+    transport.note(text.c_str());
+    counters.droppedFragments += reassemblyFragments;
+    reassemblyBuffer.clear();
+    reassemblyFragments = 0;
+    if (reassemblyPending)
+    {
+        clock.cancelTimer(TIMER_REASSEMBLY, 0);
+        reassemblyPending = false;
+    }
+}
+
+std::string ArqEndpoint::compressPayload(const std::string &data, bool &compressed)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::string packed = txCodec.compress(data);
+    counters.compressTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // The dictionary takes the frame either way; send whichever form is shorter
+    compressed = packed.size() < data.size();
+    counters.compressionBytesIn += data.size();
+    counters.compressionBytesOut += compressed ? packed.size() : data.size();
+    return compressed ? packed : data;
+}
+
+bool ArqEndpoint::decompressPayload(ReceivedFrame &received)
+{
+    if (!received.compressed)
+    {
+        rxCodec.append(received.payload);
+        return true;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::string data;
+    bool ok = rxCodec.decompress(received.payload, data);
+    counters.decompressTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (ok)
+        received.payload.swap(data);
+    return ok;
+}
+
+void ArqEndpoint::fecEncode(std::string_view framed, std::string &coded)
+{
+    switch (config.fecMode)
+    {
+    case FEC_HAMMING:
+        coded = hammingEncode(std::string(framed));
+        break;
+    case FEC_REED_SOLOMON:
+        coded = rsEncode(std::string(framed), config.fecParity);
+        break;
+    default:
+        coded.assign(framed);
+        return;
+    }
+    counters.fecOverheadBytes += coded.size() - framed.size();
+}
+
+bool ArqEndpoint::fecDecode(std::string &payload)
+{
+    if (config.fecMode == FEC_NONE)
+        return true;
+
+    std::string decoded;
+    int corrected = 0;
+    bool ok = (config.fecMode == FEC_HAMMING) ? hammingDecode(payload, decoded, corrected)
+                                              : rsDecode(payload, config.fecParity, decoded, corrected);
+    if (!ok)
+    {
+        transport.note("FEC could not repair the frame");
+        counters.fecFailures++;
+        return false;
+    }
+    if (corrected > 0)
+    {
+        transport.note("FEC corrected a damaged frame");
+        counters.fecCorrections += corrected;
+        counters.fecRepairedFrames++;
+    }
+    payload = decoded;
+    return true;
+}
+
+void ArqEndpoint::encodeFrame(std::string_view payload, size_t &bits, std::pmr::string &framed)
+{
+    auto start = std::chrono::steady_clock::now();
+    switch (config.framingMode)
+    {
+    case FRAMING_HDLC:
+        hdlcEncode(payload, framed, bits);
+        break;
+    case FRAMING_COBS:
+        cobsEncode(payload, framed);
+        bits = 8 * framed.size();
+        break;
+    default:
+        byteStuff(payload, framed);
+        bits = 8 * framed.size();
+        break;
+    }
+    counters.framingTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    counters.framingPayloadBytes += payload.size();
+    counters.framingLineBits += bits;
+}
+
+bool ArqEndpoint::decodeFrame(const std::string &framed, std::string &payload)
+{
+    auto start = std::chrono::steady_clock::now();
+    bool ok;
+    switch (config.framingMode)
+    {
+    case FRAMING_HDLC:
+        ok = hdlcDecode(framed, payload);
+        break;
+    case FRAMING_COBS:
+        ok = cobsDecode(framed, payload);
+        break;
+    default:
+        ok = byteUnstuff(framed, payload);
+        break;
+    }
+    counters.framingTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return ok;
+}
+
+char ArqEndpoint::computeCRC(std::string_view data)
+{
+    // x8 + x2 + x + 1, initialized with all 1's
+    return static_cast<char>(crc8Update(CRC8_INIT, data.data(), data.size()));
+}
+
+bool ArqEndpoint::decodeReceived(const char *wire, char crc, std::string &data)
+{
+    if (config.fecMode == FEC_NONE && config.framingMode == FRAMING_BYTE)
+    {
+        // Fast path: CRC and unstuffing in a single pass over the wire bytes
+        auto start = std::chrono::steady_clock::now();
+        uint8_t calculatedCRC;
+        bool framed = byteUnstuffCrc(wire, data, calculatedCRC);
+        counters.framingTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (!framed)
+        {
+            transport.note("Framing error");
+            return false;
+        }
+        return calculatedCRC == (uint8_t)crc;
+    }
+
+    std::string payload = wire;
+    if (!fecDecode(payload) || !checkCRC(payload, crc))
+        return false;
+    if (!decodeFrame(payload, data))
+    {
+        transport.note("Framing error");
+        return false;
+    }
+    return true;
+}
+
+bool ArqEndpoint::checkCRC(const std::string &data, char crc)
+{
+    return static_cast<unsigned char>(computeCRC(data)) == static_cast<unsigned char>(crc);
+}
+
+void ArqEndpoint::retransmitTimeout(int index)
+{
+    int slot = index % seqSpace;
+
+    // Timer may belong to a frame that has been acknowledged meanwhile
+    if (index < baseIndex || index >= currentIndex || sacked[slot])
+    {
+        endEvent();
+        return;
+    }
+
+    // Create error-free retransmission
+    ArqFrame frame;
+    buildDataFrame(index, "DataFrame", frame);
+
+    logEvent(LogRecord::TIMEOUT, slot);
+
+    // Send with additional processing delay
+    transport.transmit(frame, config.processingTime + 0.001);
+
+    // Karn: discard RTT samples for this frame and back off the timer
+    retransmitted[slot] = true;
+    lastSendTimes[slot] = clock.now();
+    counters.retransmissions++;
+    if (config.adaptiveTimeout)
+    {
+        rto = std::min(rto * 2, config.maxTimeout);
+        transport.rtoChanged(rto);
+    }
+
+    // Reset timer
+    startTimer(index);
+    endEvent();
+}
+
+void ArqEndpoint::logEvent(LogRecord::Kind kind, int number, std::string_view payload)
+{
+    record.kind = kind;
+    record.number = number;
+    record.payload.assign(payload);
+    transport.log(record);
+}
+
+void ArqEndpoint::logLater(LogRecord::Kind kind, int number, double delay)
+{
+    record.kind = kind;
+    record.number = number;
+    record.payload.clear();
+    transport.logDelayed(record, delay);
+}
+
+void ArqEndpoint::logSent(const ArqFrame &frame, std::string_view payload, int modifiedBit,
+                          bool lost, int duplicate, bool delayed, double printDelay)
+{
+    record.kind = LogRecord::SENT;
+    record.number = frame.seqNum;
+    record.payload.assign(payload);
+    record.trailer = frame.trailer;
+    record.modifiedBit = modifiedBit;
+    record.lost = lost;
+    record.duplicate = duplicate;
+    record.delayed = delayed;
+    record.delay = config.errorDelay;
+    transport.logDelayed(record, printDelay);
+}
+
+void ArqEndpoint::simulateErrors(ArqFrame &frame, const std::string &errorCode)
+{
+    std::pmr::string payload(frame.payload, &frameArena);
+
+    double processingTime = config.processingTime;
+    double errorDelay = config.errorDelay;
+    double duplicationDelay = config.duplicationDelay;
+    int bitPosition = 0;
+    // Case "0000": No error
+    if (errorCode == "0000")
+    {
+        transport.transmit(frame, processingTime);
+        logSent(frame, payload, -1, false, 0, false, processingTime);
+    }
+    // Case "0001": Delay only
+    else if (errorCode == "0001")
+    {
+        transport.transmit(frame, processingTime + errorDelay);
+        logSent(frame, payload, -1, false, 0, true, processingTime);
+    }
+    // Case "0010": Duplication without delay
+    else if (errorCode == "0010")
+    {
+        transport.transmit(frame, processingTime);
+        transport.transmit(frame, processingTime + duplicationDelay);
+        logSent(frame, payload, -1, false, 1, false, processingTime);
+        logSent(frame, payload, -1, false, 2, false, processingTime + duplicationDelay);
+    }
+    // Case "0011": Duplication with delay
+    else if (errorCode == "0011")
+    {
+        transport.transmit(frame, processingTime + errorDelay);
+        transport.transmit(frame, processingTime + errorDelay + duplicationDelay);
+        logSent(frame, payload, -1, false, 1, true, processingTime);
+        logSent(frame, payload, -1, false, 2, true, processingTime + duplicationDelay);
+    }
+    // Case "1100": Loss with modification
+    else if (errorCode == "1100")
+    {
+        bitPosition = rand() % (payload.length() * 8);
+        char &byte = payload[bitPosition / 8];
+        byte ^= (1 << (bitPosition % 8));
+
+        logSent(frame, payload, bitPosition, true, 1, false, processingTime);
+    }
+    // Case "1101": Loss with modification and delay
+    else if (errorCode == "1101")
+    {
+        bitPosition = rand() % (payload.length() * 8);
+        char &byte = payload[bitPosition / 8];
+        byte ^= (1 << (bitPosition % 8));
+
+        logSent(frame, payload, bitPosition, true, 0, true, processingTime);
+    }
+    // Case "1110": Loss with modification and duplication
+    else if (errorCode == "1110")
+    {
+        bitPosition = rand() % (payload.length() * 8);
+        char &byte = payload[bitPosition / 8];
+        byte ^= (1 << (bitPosition % 8));
+
+        logSent(frame, payload, bitPosition, true, 1, false, processingTime);
+        logSent(frame, payload, bitPosition, true, 2, false, processingTime + duplicationDelay);
+    }
+    // Case "1111": Loss with modification, duplication and delay
+    else if (errorCode == "1111")
+    {
+        bitPosition = rand() % (payload.length() * 8);
+        char &byte = payload[bitPosition / 8];
+        byte ^= (1 << (bitPosition % 8));
+
+        logSent(frame, payload, bitPosition, true, 1, true, processingTime);
+        logSent(frame, payload, bitPosition, true, 2, true, processingTime + duplicationDelay);
+    }
+    // Case "1000": Modification only
+    else if (errorCode == "1000")
+    {
+        bitPosition = rand() % (payload.length() * 8);
+        char &byte = payload[bitPosition / 8];
+        byte ^= (1 << (bitPosition % 8));
+        frame.payload = payload.c_str();
+        transport.transmit(frame, processingTime);
+        logSent(frame, payload, bitPosition, false, 0, false, processingTime);
+    }
+    // Case "1001": Modification and delay
+    else if (errorCode == "1001")
+    {
+        bitPosition = rand() % (payload.length() * 8);
+        char &byte = payload[bitPosition / 8];
+        byte ^= (1 << (bitPosition % 8));
+        frame.payload = payload.c_str();
+        transport.transmit(frame, processingTime + errorDelay);
+        logSent(frame, payload, bitPosition, false, 0, true, processingTime);
+    }
+    // Case "1010": Modification and duplication
+    else if (errorCode == "1010")
+    {
+        bitPosition = rand() % (payload.length() * 8);
+        char &byte = payload[bitPosition / 8];
+        byte ^= (1 << (bitPosition % 8));
+        frame.payload = payload.c_str();
+        transport.transmit(frame, processingTime);
+        transport.transmit(frame, processingTime + duplicationDelay);
+        logSent(frame, payload, bitPosition, false, 1, false, processingTime);
+        logSent(frame, payload, bitPosition, false, 2, false, processingTime + duplicationDelay);
+    }
+    // Case "1011": Modification, duplication and delay
+    else if (errorCode == "1011")
+    {
+        bitPosition = rand() % (payload.length() * 8);
+        char &byte = payload[bitPosition / 8];
+        byte ^= (1 << (bitPosition % 8));
+        frame.payload = payload.c_str();
+        transport.transmit(frame, processingTime + errorDelay);
+        transport.transmit(frame, processingTime + errorDelay + duplicationDelay);
+        logSent(frame, payload, bitPosition, false, 1, true, processingTime);
+        logSent(frame, payload, bitPosition, false, 2, true, processingTime + duplicationDelay);
+    }
+}
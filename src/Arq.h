@@ -0,0 +1,354 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __DATALINKLAYERNETWORK_ARQ_H_
+#define __DATALINKLAYERNETWORK_ARQ_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Compression.h"
+#include "Crc.h"
+#include "Fec.h"
+#include "Framing.h"
+#include "LogFormat.h"
+
+/**
+ * Selective-repeat ARQ endpoint: sender and receiver windows, framing, CRC,
+ * FEC, compression, aggregation, fragmentation, piggybacked and selective
+ * ACKs, and the error injection driven by the input file's error codes.
+ *
+ * The endpoint does not depend on OMNeT++. Time and timers come from an
+ * ArqClock, frames leave through an ArqTransport, and the host feeds
+ * received frames and expired timers back in. Node is such a host; the
+ * benchmark in bench/ is another, driving two endpoints from a tight
+ * in-process event loop.
+ *
+ * Callbacks must not call back into the endpoint; the host delivers frames
+ * and timer expiries as separate events.
+ */
+
+// Clock ticks; only the clock converts them to and from seconds
+typedef int64_t ArqTime;
+
+enum ArqTimer
+{
+    TIMER_RETRANSMIT, // One per frame in the send window, identified by its absolute index
+    TIMER_ACK,        // Delayed-ACK timer
+    TIMER_REASSEMBLY  // Eviction of a partially reassembled message
+};
+
+enum ArqFrameType
+{
+    FRAME_NACK = 0,
+    FRAME_ACK = 1,
+    FRAME_DATA = 2,
+    FRAME_SACK = 3,
+    FRAME_AGGREGATE = 4
+};
+
+// A frame as it crosses the link; payload points into the sender's memory
+// and is only valid during the transmit() call
+struct ArqFrame
+{
+    const char *name = "";       // "DataFrame", "RetransFrame", "ACK", "SACK" or "NACK"
+    int type = FRAME_DATA;
+    int seqNum = 0;
+    const char *payload = "";    // Framed, FEC-coded payload, NUL-terminated
+    char trailer = 0;            // CRC-8 of the framed payload
+    int ack = -1;                // Piggybacked ACK, -1 if none
+    int sack = 0;                // SACK bitmap
+    int credit = -1;             // Frames the receiver can take beyond ack, -1 if not advertised
+    int fragIndex = 0;
+    bool lastFragment = true;
+    bool compressed = false;
+    int64_t bitLength = 0;       // Length on the line, headers included
+};
+
+class ArqClock
+{
+public:
+    virtual ~ArqClock() {}
+
+    virtual ArqTime now() const = 0;
+    virtual ArqTime fromSeconds(double seconds) const = 0;
+    virtual double toSeconds(ArqTime time) const = 0;
+
+    // Arms a timer, replacing a pending one of the same kind and index;
+    // on expiry the host calls the matching ArqEndpoint handler
+    virtual void startTimer(ArqTimer timer, int index, double delay) = 0;
+    virtual void cancelTimer(ArqTimer timer, int index) = 0;
+
+    // Asks for a sendFrames() call after delay; every call adds one
+    virtual void scheduleSend(double delay) = 0;
+};
+
+// Everything the endpoint hands out: frames, delivered messages, log
+// records and statistics samples
+class ArqTransport
+{
+public:
+    virtual ~ArqTransport() {}
+
+    virtual void transmit(const ArqFrame &frame, double delay) = 0;
+    virtual void deliver(std::string_view message, int seqNum) = 0;
+
+    // Output lines: now, or after delay (the "Print" events of the log)
+    virtual void log(const LogRecord &record) = 0;
+    virtual void logDelayed(const LogRecord &record, double delay) = 0;
+
+    // Diagnostics and statistics, ignored unless overridden
+    virtual void note(const char *) {}
+    virtual void rttSample(double) {}
+    virtual void rtoChanged(double) {}
+};
+
+struct ArqConfig
+{
+    int windowSize = 4;
+    int maxSeqNumber = 7;
+    double timeoutInterval = 10;             // Fixed timeout, also the initial RTO
+    double processingTime = 0.5;
+    double errorDelay = 4;
+    double duplicationDelay = 0.1;
+
+    bool adaptiveTimeout = true;
+    double minTimeout = 1;
+    double maxTimeout = 60;
+    bool selectiveAck = false;
+
+    bool aggregation = false;
+    bool subframeCrc = false;
+    int mtu = 64;
+    bool fragmentation = false;
+    int maxReassemblyBytes = 4096;
+    double reassemblyTimeout = 0;            // Longest wait for a message's next fragment, 0 = as long as ARQ takes
+
+    FramingMode framingMode = FRAMING_BYTE;
+    bool compression = false;
+    FecMode fecMode = FEC_NONE;
+    int fecParity = 4;
+
+    bool piggybackAcks = false;
+    double ackDelay = 0.5;
+    int ackEvery = 0;
+
+    int deliveryQueue = 0;                   // Flow control: frames held for the host, advertised as credit (0 = off)
+};
+
+struct ArqStats
+{
+    long retransmissions = 0;                // Timeout, NACK and SACK retransmissions
+    long sackRetransmissions = 0;
+    long aggregateFrames = 0;
+    long aggregatedMessages = 0;
+    long fragmentsSent = 0;
+    long reassembledMessages = 0;
+    long droppedFragments = 0;
+    long framingPayloadBytes = 0;            // Payload bytes handed to the framer
+    long framingLineBits = 0;                // Line bits of the framed payloads, flags included
+    double framingTime = 0;                  // CPU seconds spent framing and deframing
+    long reusedFrames = 0;                   // Retransmissions served from the framed copy
+    long compressionBytesIn = 0;
+    long compressionBytesOut = 0;
+    double compressTime = 0;
+    double decompressTime = 0;
+    long fecCorrections = 0;                 // Bits (Hamming) or bytes (RS) repaired
+    long fecRepairedFrames = 0;              // Frames saved from a NACK round trip
+    long fecFailures = 0;
+    long fecOverheadBytes = 0;               // Extra bytes FEC adds per distinct frame
+    long standaloneAcks = 0;
+    long piggybackedAcks = 0;
+    long framesDelivered = 0;
+    long creditStalls = 0;                   // sendFrames() calls held back by the peer's credit alone
+    long windowUpdates = 0;                  // ACKs sent because consume() made room
+};
+
+class ArqEndpoint
+{
+public:
+    // Throws std::invalid_argument for an inconsistent configuration
+    ArqEndpoint(const ArqConfig &config, ArqClock &clock, ArqTransport &transport);
+
+    // Input lines, "<4-digit error code> <message>"; start() begins sending,
+    // a later start() queues its lines behind the ones not yet sent and only
+    // sends itself if there were none.
+    // queue() only adds them, for a host that calls sendFrames() itself
+    void start(std::vector<std::string> lines);
+    void queue(std::vector<std::string> lines);
+    size_t messageCount() const { return messages.size(); }
+
+    // Every input line has been sent and acknowledged
+    bool allAcknowledged() const { return nextMessage >= (int)messages.size() && baseIndex == currentIndex; }
+
+    // Events from the host. receive() and consume() throw std::runtime_error
+    // when a compressed frame cannot be decoded: the dictionaries are out of
+    // step and the session is lost
+    void receive(const ArqFrame &frame);
+    void sendFrames();
+    void retransmitTimeout(int index);
+    void ackTimeout();
+    void reassemblyTimeout();
+
+    // Flow control (deliveryQueue > 0): messages delivered in order wait in
+    // the endpoint until the host takes the oldest with consume(), which
+    // hands it to transport.deliver(); ACKs advertise the room left
+    size_t pendingDeliveries() const { return backlog.size(); }
+    void consume();
+
+    // sendFrames() would send a new frame now; a host that shares its link
+    // between endpoints asks before giving one the next send slot
+    bool readyToSend() const;
+
+    const ArqConfig &configuration() const { return config; }
+    int sequenceSpace() const { return seqSpace; }
+    const ArqStats &stats() const { return counters; }
+    bool hasRtt() const { return hasRttSample; }
+    double smoothedRtt() const { return srtt; }
+    double rttVariation() const { return rttvar; }
+    double currentRto() const { return rto; }
+
+private:
+    // Frame kept in the sender window until acknowledged
+    struct SentFrame
+    {
+        std::string payload;                 // Payload handed to the framer
+        int type = 0;                        // FRAME_DATA or FRAME_AGGREGATE
+        int fragIndex = 0;
+        bool lastFragment = true;
+        bool compressed = false;             // payload holds LZ tokens
+        std::string wire;                    // Framed and FEC-coded payload, empty until first sent
+        char crc = 0;                        // Trailer over the framed payload
+        size_t lineBits = 0;                 // Line bits of wire
+    };
+
+    // Message waiting for the host to consume it
+    struct QueuedMessage
+    {
+        std::string data;
+        int seqNum = 0;
+        bool lastOfFrame = false;            // Frees a frame's room in the queue when consumed
+    };
+
+    // Frame buffered at the receiver until it can be delivered in order
+    struct ReceivedFrame
+    {
+        std::string payload;                 // Payload with the framing removed
+        bool aggregate = false;
+        int fragIndex = 0;
+        bool lastFragment = true;
+        bool compressed = false;
+    };
+
+    ArqConfig config;
+    ArqClock &clock;
+    ArqTransport &transport;
+    ArqStats counters;
+
+    std::vector<std::string> messages;
+    int seqSpace;                            // Number of distinct sequence numbers (maxSeqNumber + 1)
+    std::vector<SentFrame> senderWindow;     // Buffer for sender window
+    std::vector<bool> frameReceived;         // Track received frames
+    std::vector<ReceivedFrame> receiverBuffer; // Buffer for receiver window
+    std::string rxScratch;                   // Decode target for frames whose slot is taken
+    std::vector<bool> ackReceived;           // Track received ACKs
+    int expectedFrameToReceive;              // Expected frame at receiver
+    int currentIndex;                        // Next absolute frame index to send
+    int baseIndex;                           // Oldest unacknowledged frame
+    int nextMessage;                         // Next input line to put into a frame
+    std::vector<std::string> subframes;      // Messages of the frame being delivered
+
+    // Adaptive retransmission timeout (RFC 6298, Karn's algorithm)
+    double srtt;                             // Smoothed round-trip time
+    double rttvar;                           // Round-trip time variation
+    double rto;                              // Current retransmission timeout
+    bool hasRttSample;                       // First RTT measurement taken
+    std::vector<ArqTime> sendTimes;          // First transmission time per window slot
+    std::vector<bool> retransmitted;         // Slot was retransmitted (no RTT sample, Karn)
+
+    // Selective acknowledgement
+    std::vector<bool> sacked;                // Slot is buffered at the receiver (from SACK)
+    std::vector<ArqTime> lastSendTimes;      // Latest (re)transmission time per slot
+
+    // Fragmentation and reassembly
+    int nextFragment;                        // Next fragment of messages[nextMessage]
+    std::string reassemblyBuffer;            // Fragments of the message being reassembled
+    int reassemblyFragments;                 // Fragments in reassemblyBuffer
+    bool reassemblyPending;                  // TIMER_REASSEMBLY is armed
+
+    // Payload compression ahead of framing
+    LzCodec txCodec;                         // Dictionary of frames sent, in sequence order
+    LzCodec rxCodec;                         // Dictionary of frames delivered, in sequence order
+
+    // Piggybacked and coalesced ACKs
+    int unackedFrames;                       // Frames delivered since the last ACK went out
+    bool ackPending;                         // TIMER_ACK is armed
+
+    // Receiver-advertised credit
+    std::deque<QueuedMessage> backlog;       // Delivered, not yet consumed by the host
+    int queuedFrames;                        // Frames with messages in backlog
+    int advertisedCredit;                    // Credit of the last ACK sent
+    int sendLimit;                           // First index the peer's credit does not cover
+
+    LogRecord record;                        // Scratch record for log lines
+
+    // Per-event scratch memory for frame assembly and error injection,
+    // released when the endpoint returns to the host
+    alignas(std::max_align_t) char arenaBuffer[16 * 1024];
+    std::pmr::monotonic_buffer_resource frameArena;
+
+    void handleAck(const ArqFrame &frame);
+    void receiveFrame(const ArqFrame &frame);
+    int deliverInOrder();
+    int credit() const;
+    void buildDataFrame(int index, const char *name, ArqFrame &frame);
+    void aggregateMessages(std::string &packed);
+    bool deaggregate(const std::string &packed, std::vector<std::string> &subframes);
+    bool reassemble(const ReceivedFrame &fragment, std::string &message);
+    void evictReassembly(const char *reason);
+    std::string compressPayload(const std::string &data, bool &compressed);
+    bool decompressPayload(ReceivedFrame &received);
+    void fecEncode(std::string_view framed, std::string &coded);
+    bool fecDecode(std::string &payload);
+    void encodeFrame(std::string_view payload, size_t &bits, std::pmr::string &framed);
+    bool decodeFrame(const std::string &framed, std::string &payload);
+    bool decodeReceived(const char *wire, char crc, std::string &data);
+    char computeCRC(std::string_view data);
+    bool checkCRC(const std::string &data, char crc);
+    void simulateErrors(ArqFrame &frame, const std::string &errorCode);
+    void logSent(const ArqFrame &frame, std::string_view payload, int modifiedBit,
+                 bool lost, int duplicate, bool delayed, double printDelay);
+    void logEvent(LogRecord::Kind kind, int number, std::string_view payload = {});
+    void logLater(LogRecord::Kind kind, int number, double delay);
+    void sendAck(int nextExpected);
+    void scheduleAck(bool immediate);
+    void attachAck(ArqFrame &frame);
+    void processAck(int ackSeqNum, int sackBitmap, int peerCredit);
+    void processSack(int sackBitmap);
+    int buildSackBitmap() const;
+    void retransmitFrame(int index);
+    bool windowOpen() const;
+    int unwrapSeqNum(int seqNum, int reference) const;
+    void startTimer(int index);
+    void stopTimer(int index);
+    void updateRtt(double sample);
+    void endEvent() { frameArena.release(); }
+};
+
+#endif
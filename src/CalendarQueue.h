@@ -0,0 +1,191 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __DATALINKLAYERNETWORK_CALENDARQUEUE_H_
+#define __DATALINKLAYERNETWORK_CALENDARQUEUE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Calendar queue (R. Brown, CACM 1988): a priority queue of timestamped
+ * items with O(1) average push and pop when the timestamps are spread
+ * evenly, as a node's retransmission timers are. Time is cut into buckets
+ * of equal width, and a bucket holds every item whose time falls into
+ * it in any "year" (the calendar's length), earliest last. pop() walks
+ * the buckets of the current year in order; the bucket count follows the
+ * item count, and the width is re-estimated from the spacing of the
+ * earliest items each time. A cancelled timer can be removed, which only
+ * searches its own bucket.
+ *
+ * T needs an int64_t at (raw time) and a uint64_t order that breaks ties
+ * first in, first out. Items must not be pushed earlier than the last
+ * popped one.
+ */
+template <typename T>
+class CalendarQueue
+{
+public:
+    CalendarQueue() { rebuild(MIN_BUCKETS); }
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+    void push(const T &item)
+    {
+        insert(item);
+        count++;
+        if (item.at < bucketTop - width)
+        {
+            // Earlier than the bucket the search stands on
+            current = bucketOf(item.at);
+            bucketTop = (item.at / width + 1) * width;
+        }
+        found = false;
+        if (count > 2 * buckets.size())
+            rebuild(2 * buckets.size());
+    }
+
+    // The earliest item; the queue must not be empty
+    const T &top()
+    {
+        locate();
+        return buckets[current].back();
+    }
+
+    void pop()
+    {
+        locate();
+        buckets[current].pop_back();
+        shrunk();
+    }
+
+    // Removes the item with item's time and order; false if there is none
+    bool remove(const T &item)
+    {
+        std::vector<T> &bucket = buckets[bucketOf(item.at)];
+        auto it = std::lower_bound(bucket.begin(), bucket.end(), item,
+                                   [](const T &a, const T &b) { return earlier(b, a); });
+        if (it == bucket.end() || it->at != item.at || it->order != item.order)
+            return false;
+        bucket.erase(it);
+        shrunk();
+        return true;
+    }
+
+private:
+    static const size_t MIN_BUCKETS = 4;
+    static const size_t WIDTH_SAMPLE = 25; // Earliest items the bucket width is estimated from
+
+    std::vector<std::vector<T>> buckets;
+    int64_t width = 1;
+    size_t count = 0;
+    size_t current = 0;    // Bucket the search stands on
+    int64_t bucketTop = 1; // End of that bucket's slice of time in the current year
+    bool found = false;    // current holds the earliest item
+
+    static bool earlier(const T &a, const T &b)
+    {
+        return a.at != b.at ? a.at < b.at : a.order < b.order;
+    }
+
+    size_t bucketOf(int64_t at) const
+    {
+        return (size_t)(at / width) % buckets.size();
+    }
+
+    void shrunk()
+    {
+        count--;
+        found = false;
+        // Halving at a quarter, not at half, keeps a queue that hovers
+        // around a threshold from rebuilding on every push and pop
+        if (buckets.size() > MIN_BUCKETS && count < buckets.size() / 4)
+            rebuild(buckets.size() / 2);
+    }
+
+    void insert(const T &item)
+    {
+        // Descending, so the earliest item leaves with pop_back()
+        std::vector<T> &bucket = buckets[bucketOf(item.at)];
+        bucket.insert(std::upper_bound(bucket.begin(), bucket.end(), item,
+                                       [](const T &a, const T &b) { return earlier(b, a); }),
+                      item);
+    }
+
+    void locate()
+    {
+        if (found)
+            return;
+        // The earliest item due within a year from here
+        size_t i = current;
+        int64_t top = bucketTop;
+        for (size_t n = 0; n < buckets.size(); n++)
+        {
+            if (!buckets[i].empty() && buckets[i].back().at < top)
+            {
+                current = i;
+                bucketTop = top;
+                found = true;
+                return;
+            }
+            i = (i + 1) % buckets.size();
+            top += width;
+        }
+
+        // A sparse year: jump straight to the earliest item
+        const T *earliest = nullptr;
+        for (size_t j = 0; j < buckets.size(); j++)
+        {
+            if (!buckets[j].empty() && (!earliest || earlier(buckets[j].back(), *earliest)))
+            {
+                earliest = &buckets[j].back();
+                current = j;
+            }
+        }
+        bucketTop = (earliest->at / width + 1) * width;
+        found = true;
+    }
+
+    void rebuild(size_t bucketCount)
+    {
+        std::vector<T> items;
+        items.reserve(count);
+        for (std::vector<T> &bucket : buckets)
+            items.insert(items.end(), bucket.begin(), bucket.end());
+        std::sort(items.begin(), items.end(), earlier);
+
+        // Three times the mean gap between the earliest distinct times;
+        // items that share a time say nothing about the width
+        size_t n = std::min(items.size(), WIDTH_SAMPLE);
+        int64_t gaps = 0;
+        for (size_t i = 1; i < n; i++)
+            gaps += items[i].at != items[i - 1].at;
+        if (gaps > 0)
+            width = std::max<int64_t>(1, 3 * (items[n - 1].at - items[0].at) / gaps);
+
+        buckets.assign(bucketCount, std::vector<T>());
+        for (auto it = items.rbegin(); it != items.rend(); ++it)
+            buckets[bucketOf(it->at)].push_back(*it);
+        int64_t start = items.empty() ? 0 : items.front().at;
+        current = bucketOf(start);
+        bucketTop = (start / width + 1) * width;
+        found = false;
+    }
+};
+
+#endif
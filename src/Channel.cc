@@ -0,0 +1,135 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+#include "Channel.h"
+#include <cmath>
+
+Define_Module(Channel);
+
+Channel::~Channel()
+{
+    cancelAndDelete(endTxMsg);
+}
+
+void Channel::initialize()
+{
+    datarate = par("datarate").doubleValue();
+    propagationDelay = par("propagationDelay").doubleValue();
+    queueLimit = par("queueLimit").intValue();
+
+    std::string policy = par("dropPolicy").stdstringValue();
+    if (policy != "tail" && policy != "head")
+        throw cRuntimeError("Unknown dropPolicy '%s', expected \"tail\" or \"head\"", policy.c_str());
+    dropHead = (policy == "head");
+
+    txQueue.setName("txQueue");
+    endTxMsg = new cMessage("EndTransmission");
+
+    framesSent = 0;
+    framesDropped = 0;
+    bitsSent = 0;
+    busyTime = 0;
+    maxQueueLength = 0;
+
+    if (datarate > 0)
+    {
+        EV << "Channel " << getIndex() << ": bandwidth-delay product = "
+           << datarate * propagationDelay << " bits\n";
+    }
+}
+
+void Channel::handleMessage(cMessage *msg)
+{
+    if (msg == endTxMsg)
+    {
+        // Transmitter is free again, serve the next queued frame
+        if (!txQueue.isEmpty())
+            startTransmission(check_and_cast<cPacket *>(txQueue.pop()));
+        return;
+    }
+
+    cPacket *pkt = check_and_cast<cPacket *>(msg);
+
+    if (!endTxMsg->isScheduled())
+    {
+        startTransmission(pkt);
+        return;
+    }
+
+    // Link busy: queue the frame, dropping one if the queue is full
+    if (queueLimit > 0 && txQueue.getLength() >= queueLimit)
+    {
+        framesDropped++;
+        if (dropHead)
+        {
+            cPacket *oldest = check_and_cast<cPacket *>(txQueue.pop());
+            EV << "Transmit queue full, dropping oldest frame " << oldest->getName() << "\n";
+            delete oldest;
+        }
+        else
+        {
+            EV << "Transmit queue full, dropping arriving frame " << pkt->getName() << "\n";
+            delete pkt;
+            return;
+        }
+    }
+
+    txQueue.insert(pkt);
+    if (txQueue.getLength() > maxQueueLength)
+        maxQueueLength = txQueue.getLength();
+}
+
+simtime_t Channel::serializationDelay(cPacket *pkt) const
+{
+    if (datarate <= 0)
+        return SIMTIME_ZERO;
+    return pkt->getBitLength() / datarate;
+}
+
+void Channel::startTransmission(cPacket *pkt)
+{
+    simtime_t txTime = serializationDelay(pkt);
+
+    framesSent++;
+    bitsSent += pkt->getBitLength();
+    busyTime += txTime;
+
+    // The last bit leaves after txTime and needs propagationDelay to arrive
+    sendDelayed(pkt, txTime + propagationDelay, "out");
+
+    if (txTime > SIMTIME_ZERO)
+        scheduleAt(simTime() + txTime, endTxMsg);
+}
+
+void Channel::finish()
+{
+    recordScalar("framesSent", framesSent);
+    recordScalar("framesDropped", framesDropped);
+    recordScalar("maxQueueLength", maxQueueLength);
+
+    if (simTime() > SIMTIME_ZERO)
+    {
+        recordScalar("utilization", busyTime / simTime());
+        recordScalar("throughput", bitsSent / simTime().dbl());
+    }
+
+    // Sliding window keeps the link busy when W >= 1 + 2a, a = Tprop / Ttx
+    if (datarate > 0 && framesSent > 0)
+    {
+        double meanTxTime = (double)bitsSent / framesSent / datarate;
+        double a = propagationDelay / meanTxTime;
+        recordScalar("bandwidthDelayProduct", datarate * propagationDelay);
+        recordScalar("suggestedWindowSize", std::ceil(1 + 2 * a));
+    }
+}
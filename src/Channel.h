@@ -0,0 +1,59 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __DATALINKLAYERNET_CHANNEL_H_
+#define __DATALINKLAYERNET_CHANNEL_H_
+
+#include <omnetpp.h>
+
+using namespace omnetpp;
+
+/**
+ * One direction of the link between the two nodes. Models serialization
+ * delay (frame length / datarate), propagation delay and a bounded FIFO
+ * transmit queue with tail- or head-drop.
+ */
+class Channel : public cSimpleModule
+{
+private:
+    double datarate;         // Link capacity in bit/s (0 = unlimited)
+    double propagationDelay; // Propagation delay in seconds
+    int queueLimit;          // Max queued frames (0 = unbounded)
+    bool dropHead;           // Drop the oldest queued frame instead of the arriving one
+
+    cQueue txQueue;          // Frames waiting for the transmitter
+    cMessage *endTxMsg;      // Fires when the current frame is fully serialized
+
+    // Statistics
+    long framesSent;
+    long framesDropped;
+    long bitsSent;
+    simtime_t busyTime;      // Total time spent serializing frames
+    int maxQueueLength;
+
+    void startTransmission(cPacket *pkt);
+    simtime_t serializationDelay(cPacket *pkt) const;
+
+protected:
+    virtual void initialize() override;
+    virtual void handleMessage(cMessage *msg) override;
+    virtual void finish() override;
+
+public:
+    Channel() : endTxMsg(nullptr) {}
+    virtual ~Channel();
+};
+
+#endif
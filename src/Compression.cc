@@ -0,0 +1,167 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+#include "Compression.h"
+#include <algorithm>
+#include <cstring>
+
+LzCodec::LzCodec() : historyBase(0), hashed(0), table(1 << HASH_BITS, 0)
+{
+}
+
+uint32_t LzCodec::hash(const char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Keep between one and two windows of history, so erasing the front is amortized
+void LzCodec::trim()
+{
+    if (history.size() <= 2 * (size_t)WINDOW)
+        return;
+    size_t drop = history.size() - WINDOW;
+    history.erase(0, drop);
+    historyBase += drop;
+}
+
+std::string LzCodec::compress(const std::string &data)
+{
+    size_t start = history.size();
+    history += data;
+    const char *buf = history.data();
+    size_t end = history.size();
+
+    // Hash the tail of earlier frames, which lacked MIN_MATCH bytes until now
+    hashed = std::max(hashed, historyBase);
+    while (hashed < historyBase + start && hashed - historyBase + MIN_MATCH <= end)
+    {
+        table[hash(buf + (hashed - historyBase))] = hashed + 1;
+        hashed++;
+    }
+
+    std::string out;
+    out.reserve(data.size() + data.size() / 8 + 1);
+
+    size_t pos = start;
+    while (pos < end)
+    {
+        size_t len = 0;
+        size_t offset = 0;
+
+        if (pos + MIN_MATCH <= end)
+        {
+            uint32_t h = hash(buf + pos);
+            uint64_t candidate = table[h];
+            table[h] = historyBase + pos + 1;
+
+            // Single probe: the latest position with the same hash, if still in the window
+            if (candidate > historyBase)
+            {
+                size_t c = candidate - 1 - historyBase;
+                offset = pos - c;
+                if (offset <= (size_t)WINDOW && memcmp(buf + c, buf + pos, MIN_MATCH) == 0)
+                {
+                    size_t maxLen = std::min<size_t>(MAX_MATCH, end - pos);
+                    len = MIN_MATCH;
+                    while (len < maxLen && buf[c + len] == buf[pos + len])
+                        len++;
+                }
+            }
+        }
+
+        if (len >= (size_t)MIN_MATCH)
+        {
+            out += (char)(0x80 | (len - MIN_MATCH));
+            out += (char)(0x80 | ((offset - 1) >> 7));
+            out += (char)(0x80 | ((offset - 1) & 0x7F));
+
+            // Positions inside the match stay reachable for later matches
+            for (size_t p = pos + 1; p < pos + len && p + MIN_MATCH <= end; p++)
+                table[hash(buf + p)] = historyBase + p + 1;
+            pos += len;
+        }
+        else
+        {
+            unsigned char b = buf[pos];
+            if (b >= 0x80)
+                out += (char)0xFF;
+            out += (char)b;
+            pos++;
+        }
+    }
+
+    // Every position with MIN_MATCH bytes after it is now hashed
+    if (hashed == historyBase + start && end >= start + MIN_MATCH)
+        hashed = historyBase + end - MIN_MATCH + 1;
+
+    trim();
+    return out;
+}
+
+void LzCodec::append(const std::string &data)
+{
+    history += data;
+    trim();
+}
+
+bool LzCodec::decompress(const std::string &packed, std::string &data)
+{
+    size_t start = history.size();
+    size_t n = packed.size();
+    size_t i = 0;
+
+    while (i < n)
+    {
+        unsigned char token = packed[i++];
+        if (token < 0x80)
+        {
+            history += (char)token;
+        }
+        else if (token == 0xFF)
+        {
+            if (i >= n)
+                break;
+            history += packed[i++];
+        }
+        else
+        {
+            if (i + 2 > n)
+                break;
+            unsigned char hi = packed[i];
+            unsigned char lo = packed[i + 1];
+            size_t offset = ((size_t)(hi & 0x7F) << 7 | (lo & 0x7F)) + 1;
+            size_t len = (token & 0x7F) + MIN_MATCH;
+            if (!(hi & 0x80) || !(lo & 0x80) || offset > history.size())
+                break;
+            i += 2;
+
+            // Byte by byte, as the match may overlap the bytes it produces
+            size_t from = history.size() - offset;
+            for (size_t k = 0; k < len; k++)
+                history += history[from + k];
+        }
+    }
+
+    if (i < n)
+    {
+        history.resize(start);
+        return false;
+    }
+
+    data.assign(history, start, std::string::npos);
+    trim();
+    return true;
+}
@@ -0,0 +1,66 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __DATALINKLAYERNETWORK_COMPRESSION_H_
+#define __DATALINKLAYERNETWORK_COMPRESSION_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * Byte-oriented LZ77 codec in the spirit of LZ4, with a sliding dictionary
+ * that persists for the whole session. Every frame is compressed against the
+ * frames that came before it, so repeated text across lines collapses into
+ * back-references. One instance handles one direction of one link; the
+ * sender and receiver stay in sync as long as frames are fed in sequence order.
+ *
+ * Token format (never produces '\0', as M_Payload is a C string):
+ *   0x01..0x7F   literal byte
+ *   0xFF b       literal byte b >= 0x80
+ *   0x80..0xFE   match of length (token & 0x7F) + MIN_MATCH, followed by
+ *                two offset bytes 0x80 | 7 bits (high half first)
+ */
+class LzCodec
+{
+public:
+    static const int MIN_MATCH = 4;
+    static const int MAX_MATCH = 0x7E + MIN_MATCH;
+    static const int WINDOW = 1 << 14;     // Largest offset two 7-bit bytes can address
+
+    LzCodec();
+
+    // Compresses data and adds it to the dictionary
+    std::string compress(const std::string &data);
+
+    // Adds data to the dictionary without compressing it (frame went out raw)
+    void append(const std::string &data);
+
+    // Expands packed and adds the result to the dictionary; false on malformed input
+    bool decompress(const std::string &packed, std::string &data);
+
+private:
+    static const int HASH_BITS = 12;
+
+    std::string history;                   // Dictionary: the latest bytes of the session
+    uint64_t historyBase;                  // Stream offset of history[0]
+    uint64_t hashed;                       // Stream offset up to which positions are hashed
+    std::vector<uint64_t> table;           // Hash of 4 bytes -> stream offset + 1 (0 = empty)
+
+    static uint32_t hash(const char *p);
+    void trim();
+};
+
+#endif
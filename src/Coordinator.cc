@@ -12,49 +12,107 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with this program.  If not, see http://www.gnu.org/licenses/.
 // 
-#include "omnetpp.h"  // Required for simtime_t
 #include "Coordinator.h"
-#include <fstream>      // For file input/output
+#include <cstdlib>
+#include <sstream>
 
 Define_Module(Coordinator);
 
+Coordinator::~Coordinator()
+{
+    cancelAndDelete(nextStart);
+}
+
 void Coordinator::initialize()
 {
     const char *fileName = par("inputFile").stringValue();
-           std::ifstream file;
+    fullDuplex = par("fullDuplex").boolValue();
+
+    schedule.open(fileName, std::ifstream::in);
+    if (!schedule.is_open())
+    {
+        EV << "Failed to open " << fileName << "\n";
+        return;
+    }
+
+    nextStart = new cMessage("NextSession");
+    if (readSession())
+    {
+        EV << "Coordinator initialized. Node " << next.node << " will start at " << next.startTime << "s.\n";
+        scheduleAt(next.startTime, nextStart);
+    }
+}
+
+bool Coordinator::readSession()
+{
+    std::string line;
+    while (std::getline(schedule, line))
+    {
+        scheduleLine++;
+        std::istringstream fields(line);
+        std::string node, startTime;
+        if (!(fields >> node) || node[0] == '#')
+            continue;
 
-           file.open(fileName, std::ifstream::in);
+        Session session;
+        if (!(fields >> startTime))
+            throw cRuntimeError("%s:%d: expected <node> <start time> [<input file>]",
+                                par("inputFile").stringValue(), scheduleLine);
+        session.node = std::atoi(node.c_str());
+        session.startTime = SimTime::parse(startTime.c_str());
+        fields >> session.inputFile;
 
-           if (!file.is_open()) {
-               EV << "Failed to open " << fileName << "\n";
-               return;
-           }
+        if (session.node < 0 || session.node >= gateSize("out"))
+            throw cRuntimeError("%s:%d: no node %d", par("inputFile").stringValue(), scheduleLine, session.node);
+        if (session.startTime < simTime())
+            throw cRuntimeError("%s:%d: start time %s is before the previous session's",
+                                par("inputFile").stringValue(), scheduleLine, session.startTime.str().c_str());
+        next = std::move(session);
+        return true;
+    }
+    return false;
+}
 
-           // Read starting node ID and start time
+void Coordinator::handleMessage(cMessage *msg)
+{
+    // Every session due now, then the next one is scheduled in the same message
+    bool more;
+    do
+    {
+        startSession(next);
+        more = readSession();
+    }
+    while (more && next.startTime == simTime());
 
-           std::string startTimeStr;
-           file >> nodeId >> startTimeStr;
-           file.close();
+    if (more)
+        scheduleAt(next.startTime, msg);
+}
 
-           // Convert startTimeStr to simtime_t
-           simtime_t startTime = SimTime::parse(startTimeStr.c_str());
+void Coordinator::startSession(const Session &session)
+{
+    EV << "Sending message from Coordinator to node " << session.node << ".\n";
+    sessionsStarted++;
 
-           EV << "Start Time (simtime_t): " << startTime << "s\n";
-           // Send start signal to the chosen node
-           cMessage *startMsg = new cMessage("StartTransmission");
-           scheduleAt(simTime() + 0.1 , startMsg);
-           EV << "Coordinator initialized. Node " << nodeId << " will start at " << startTime << "s.\n";
-           EV << "Scheduling start message at: " << simTime() + startTime << "s.\n";
+    sendStart(session, session.node);
 
+    int peer = 1 - session.node;
+    if (fullDuplex && !started[peer])
+    {
+        // Both nodes transmit at once, ACKs can ride on data frames
+        sendStart(session, peer);
+    }
 }
 
-void Coordinator::handleMessage(cMessage *msg)
+void Coordinator::sendStart(const Session &session, int node)
 {
-    EV<<"------------";
-    if(msg->isSelfMessage())
-        {
-            EV << "Sending message from Coordinator to node " << nodeId << ".\n";
-            send(msg, "out", nodeId);
-        }
+    cMessage *startMsg = new cMessage("StartTransmission");
+    if (!session.inputFile.empty())
+        startMsg->addPar("inputFile").setStringValue(session.inputFile.c_str());
+    send(startMsg, "out", node);
+    started[node] = true;
+}
 
+void Coordinator::finish()
+{
+    recordScalar("sessionsStarted", sessionsStarted);
 }
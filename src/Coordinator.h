@@ -17,19 +17,61 @@
 #define __DATALINKLAYERNET_COORDINATOR_H_
 
 #include <omnetpp.h>
+#include <fstream>
+#include <string>
 
 using namespace omnetpp;
 
 /**
- * TODO - Generated class
+ * Starts the nodes' sessions from a schedule file (inputFile), one session
+ * per line:
+ *
+ *   <node> <start time> [<input file>]
+ *
+ * node is the coordinator's output gate (0 or 1) and start time is absolute
+ * simulation time ("10", "2.5s", "300ms"). Without an input file the node
+ * sends its own (Node's inputFile parameter). A node started again queues
+ * the new lines behind what it is still sending. Blank lines and lines
+ * starting with # are skipped.
+ *
+ * With fullDuplex the first session also starts the other node, with the
+ * same input file, so that both send; after that each node sends only
+ * what its own lines schedule.
+ *
+ * The schedule must be in order of start time. It is read one line ahead
+ * of the simulation, so a schedule of any length costs one pending event
+ * and one buffered session.
  */
 class Coordinator : public cSimpleModule
 {
 private:
-    int nodeId;
-  protected:
+    struct Session
+    {
+        int node = 0;
+        simtime_t startTime;
+        std::string inputFile;               // Empty for the node's own
+    };
+
+    bool fullDuplex;                         // Also start the other node of each session
+    bool started[2] = {false, false};        // Node has had a session, its own or its peer's
+    std::ifstream schedule;
+    int scheduleLine = 0;                    // Lines read so far, for error messages
+    Session next;                            // Read, not yet started
+    cMessage *nextStart;                     // Fires at next.startTime
+    long sessionsStarted = 0;
+
+    bool readSession();
+    void startSession(const Session &session);
+    void sendStart(const Session &session, int node);
+
+protected:
     virtual void initialize() override;
     virtual void handleMessage(cMessage *msg) override;
+    virtual void finish() override;
+
+public:
+    Coordinator() : nextStart(nullptr) {}
+    virtual ~Coordinator();
 };
 
 #endif
@@ -0,0 +1,39 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __DATALINKLAYERNETWORK_CRC_H_
+#define __DATALINKLAYERNETWORK_CRC_H_
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * CRC-8 of the frame trailer: polynomial x^8 + x^2 + x + 1 (0x07), initial
+ * value 0xFF, no reflection and no final XOR. Table-driven, one lookup per
+ * byte; crc8Update() continues a running CRC, so a frame can be checksummed
+ * piecewise as its bytes become available.
+ */
+const uint8_t CRC8_INIT = 0xFF;
+
+extern const uint8_t crc8Table[256];
+
+inline uint8_t crc8Update(uint8_t crc, char c)
+{
+    return crc8Table[crc ^ (uint8_t)c];
+}
+
+uint8_t crc8Update(uint8_t crc, const char *data, size_t length);
+
+#endif
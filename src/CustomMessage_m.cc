@@ -179,6 +179,13 @@ void CustomMessage::copy(const CustomMessage& other)
     this->M_Payload = other.M_Payload;
     this->M_Trailer = other.M_Trailer;
     this->M_Type = other.M_Type;
+    this->M_Ack = other.M_Ack;
+    this->M_Sack = other.M_Sack;
+    this->M_FragIndex = other.M_FragIndex;
+    this->M_LastFragment = other.M_LastFragment;
+    this->M_Compressed = other.M_Compressed;
+    this->M_Credit = other.M_Credit;
+    this->M_Stream = other.M_Stream;
 }
 
 void CustomMessage::parsimPack(omnetpp::cCommBuffer *b) const
@@ -188,6 +195,13 @@ void CustomMessage::parsimPack(omnetpp::cCommBuffer *b) const
     doParsimPacking(b,this->M_Payload);
     doParsimPacking(b,this->M_Trailer);
     doParsimPacking(b,this->M_Type);
+    doParsimPacking(b,this->M_Ack);
+    doParsimPacking(b,this->M_Sack);
+    doParsimPacking(b,this->M_FragIndex);
+    doParsimPacking(b,this->M_LastFragment);
+    doParsimPacking(b,this->M_Compressed);
+    doParsimPacking(b,this->M_Credit);
+    doParsimPacking(b,this->M_Stream);
 }
 
 void CustomMessage::parsimUnpack(omnetpp::cCommBuffer *b)
@@ -197,6 +211,13 @@ void CustomMessage::parsimUnpack(omnetpp::cCommBuffer *b)
     doParsimUnpacking(b,this->M_Payload);
     doParsimUnpacking(b,this->M_Trailer);
     doParsimUnpacking(b,this->M_Type);
+    doParsimUnpacking(b,this->M_Ack);
+    doParsimUnpacking(b,this->M_Sack);
+    doParsimUnpacking(b,this->M_FragIndex);
+    doParsimUnpacking(b,this->M_LastFragment);
+    doParsimUnpacking(b,this->M_Compressed);
+    doParsimUnpacking(b,this->M_Credit);
+    doParsimUnpacking(b,this->M_Stream);
 }
 
 char CustomMessage::getM_Header() const
@@ -239,6 +260,76 @@ void CustomMessage::setM_Type(int M_Type)
     this->M_Type = M_Type;
 }
 
+int CustomMessage::getM_Ack() const
+{
+    return this->M_Ack;
+}
+
+void CustomMessage::setM_Ack(int M_Ack)
+{
+    this->M_Ack = M_Ack;
+}
+
+int CustomMessage::getM_Sack() const
+{
+    return this->M_Sack;
+}
+
+void CustomMessage::setM_Sack(int M_Sack)
+{
+    this->M_Sack = M_Sack;
+}
+
+int CustomMessage::getM_FragIndex() const
+{
+    return this->M_FragIndex;
+}
+
+void CustomMessage::setM_FragIndex(int M_FragIndex)
+{
+    this->M_FragIndex = M_FragIndex;
+}
+
+bool CustomMessage::getM_LastFragment() const
+{
+    return this->M_LastFragment;
+}
+
+void CustomMessage::setM_LastFragment(bool M_LastFragment)
+{
+    this->M_LastFragment = M_LastFragment;
+}
+
+bool CustomMessage::getM_Compressed() const
+{
+    return this->M_Compressed;
+}
+
+void CustomMessage::setM_Compressed(bool M_Compressed)
+{
+    this->M_Compressed = M_Compressed;
+}
+
+int CustomMessage::getM_Credit() const
+{
+    return this->M_Credit;
+}
+
+void CustomMessage::setM_Credit(int M_Credit)
+{
+    this->M_Credit = M_Credit;
+}
+
+int CustomMessage::getM_Stream() const
+{
+    return this->M_Stream;
+}
+
+void CustomMessage::setM_Stream(int M_Stream)
+{
+    this->M_Stream = M_Stream;
+}
+
 class CustomMessageDescriptor : public omnetpp::cClassDescriptor
 {
   private:
@@ -248,6 +339,13 @@ class CustomMessageDescriptor : public omnetpp::cClassDescriptor
         FIELD_M_Payload,
         FIELD_M_Trailer,
         FIELD_M_Type,
+        FIELD_M_Ack,
+        FIELD_M_Sack,
+        FIELD_M_FragIndex,
+        FIELD_M_LastFragment,
+        FIELD_M_Compressed,
+        FIELD_M_Credit,
+        FIELD_M_Stream,
     };
   public:
     CustomMessageDescriptor();
@@ -314,7 +412,7 @@ const char *CustomMessageDescriptor::getProperty(const char *propertyName) const
 int CustomMessageDescriptor::getFieldCount() const
 {
     omnetpp::cClassDescriptor *base = getBaseClassDescriptor();
-    return base ? 4+base->getFieldCount() : 4;
+    return base ? 11+base->getFieldCount() : 11;
 }
 
 unsigned int CustomMessageDescriptor::getFieldTypeFlags(int field) const
@@ -330,8 +428,15 @@ unsigned int CustomMessageDescriptor::getFieldTypeFlags(int field) const
         FD_ISEDITABLE,    // FIELD_M_Payload
         FD_ISEDITABLE,    // FIELD_M_Trailer
         FD_ISEDITABLE,    // FIELD_M_Type
+        FD_ISEDITABLE,    // FIELD_M_Ack
+        FD_ISEDITABLE,    // FIELD_M_Sack
+        FD_ISEDITABLE,    // FIELD_M_FragIndex
+        FD_ISEDITABLE,    // FIELD_M_LastFragment
+        FD_ISEDITABLE,    // FIELD_M_Compressed
+        FD_ISEDITABLE,    // FIELD_M_Credit
+        FD_ISEDITABLE,    // FIELD_M_Stream
     };
-    return (field >= 0 && field < 4) ? fieldTypeFlags[field] : 0;
+    return (field >= 0 && field < 11) ? fieldTypeFlags[field] : 0;
 }
 
 const char *CustomMessageDescriptor::getFieldName(int field) const
@@ -347,8 +452,15 @@ const char *CustomMessageDescriptor::getFieldName(int field) const
         "M_Payload",
         "M_Trailer",
         "M_Type",
+        "M_Ack",
+        "M_Sack",
+        "M_FragIndex",
+        "M_LastFragment",
+        "M_Compressed",
+        "M_Credit",
+        "M_Stream",
     };
-    return (field >= 0 && field < 4) ? fieldNames[field] : nullptr;
+    return (field >= 0 && field < 11) ? fieldNames[field] : nullptr;
 }
 
 int CustomMessageDescriptor::findField(const char *fieldName) const
@@ -359,6 +471,13 @@ int CustomMessageDescriptor::findField(const char *fieldName) const
     if (strcmp(fieldName, "M_Payload") == 0) return baseIndex + 1;
     if (strcmp(fieldName, "M_Trailer") == 0) return baseIndex + 2;
     if (strcmp(fieldName, "M_Type") == 0) return baseIndex + 3;
+    if (strcmp(fieldName, "M_Ack") == 0) return baseIndex + 4;
+    if (strcmp(fieldName, "M_Sack") == 0) return baseIndex + 5;
+    if (strcmp(fieldName, "M_FragIndex") == 0) return baseIndex + 6;
+    if (strcmp(fieldName, "M_LastFragment") == 0) return baseIndex + 7;
+    if (strcmp(fieldName, "M_Compressed") == 0) return baseIndex + 8;
+    if (strcmp(fieldName, "M_Credit") == 0) return baseIndex + 9;
+    if (strcmp(fieldName, "M_Stream") == 0) return baseIndex + 10;
     return base ? base->findField(fieldName) : -1;
 }
 
@@ -375,8 +494,15 @@ const char *CustomMessageDescriptor::getFieldTypeString(int field) const
         "string",    // FIELD_M_Payload
         "char",    // FIELD_M_Trailer
         "int",    // FIELD_M_Type
+        "int",    // FIELD_M_Ack
+        "int",    // FIELD_M_Sack
+        "int",    // FIELD_M_FragIndex
+        "bool",    // FIELD_M_LastFragment
+        "bool",    // FIELD_M_Compressed
+        "int",    // FIELD_M_Credit
+        "int",    // FIELD_M_Stream
     };
-    return (field >= 0 && field < 4) ? fieldTypeStrings[field] : nullptr;
+    return (field >= 0 && field < 11) ? fieldTypeStrings[field] : nullptr;
 }
 
 const char **CustomMessageDescriptor::getFieldPropertyNames(int field) const
@@ -463,6 +589,13 @@ std::string CustomMessageDescriptor::getFieldValueAsString(omnetpp::any_ptr obje
         case FIELD_M_Payload: return oppstring2string(pp->getM_Payload());
         case FIELD_M_Trailer: return long2string(pp->getM_Trailer());
         case FIELD_M_Type: return long2string(pp->getM_Type());
+        case FIELD_M_Ack: return long2string(pp->getM_Ack());
+        case FIELD_M_Sack: return long2string(pp->getM_Sack());
+        case FIELD_M_FragIndex: return long2string(pp->getM_FragIndex());
+        case FIELD_M_LastFragment: return bool2string(pp->getM_LastFragment());
+        case FIELD_M_Compressed: return bool2string(pp->getM_Compressed());
+        case FIELD_M_Credit: return long2string(pp->getM_Credit());
+        case FIELD_M_Stream: return long2string(pp->getM_Stream());
         default: return "";
     }
 }
@@ -483,6 +616,13 @@ void CustomMessageDescriptor::setFieldValueAsString(omnetpp::any_ptr object, int
         case FIELD_M_Payload: pp->setM_Payload((value)); break;
         case FIELD_M_Trailer: pp->setM_Trailer(string2long(value)); break;
         case FIELD_M_Type: pp->setM_Type(string2long(value)); break;
+        case FIELD_M_Ack: pp->setM_Ack(string2long(value)); break;
+        case FIELD_M_Sack: pp->setM_Sack(string2long(value)); break;
+        case FIELD_M_FragIndex: pp->setM_FragIndex(string2long(value)); break;
+        case FIELD_M_LastFragment: pp->setM_LastFragment(string2bool(value)); break;
+        case FIELD_M_Compressed: pp->setM_Compressed(string2bool(value)); break;
+        case FIELD_M_Credit: pp->setM_Credit(string2long(value)); break;
+        case FIELD_M_Stream: pp->setM_Stream(string2long(value)); break;
         default: throw omnetpp::cRuntimeError("Cannot set field %d of class 'CustomMessage'", field);
     }
 }
@@ -501,6 +641,13 @@ omnetpp::cValue CustomMessageDescriptor::getFieldValue(omnetpp::any_ptr object,
         case FIELD_M_Payload: return pp->getM_Payload();
         case FIELD_M_Trailer: return pp->getM_Trailer();
         case FIELD_M_Type: return pp->getM_Type();
+        case FIELD_M_Ack: return pp->getM_Ack();
+        case FIELD_M_Sack: return pp->getM_Sack();
+        case FIELD_M_FragIndex: return pp->getM_FragIndex();
+        case FIELD_M_LastFragment: return pp->getM_LastFragment();
+        case FIELD_M_Compressed: return pp->getM_Compressed();
+        case FIELD_M_Credit: return pp->getM_Credit();
+        case FIELD_M_Stream: return pp->getM_Stream();
         default: throw omnetpp::cRuntimeError("Cannot return field %d of class 'CustomMessage' as cValue -- field index out of range?", field);
     }
 }
@@ -521,6 +668,13 @@ void CustomMessageDescriptor::setFieldValue(omnetpp::any_ptr object, int field,
         case FIELD_M_Payload: pp->setM_Payload(value.stringValue()); break;
         case FIELD_M_Trailer: pp->setM_Trailer(omnetpp::checked_int_cast<char>(value.intValue())); break;
         case FIELD_M_Type: pp->setM_Type(omnetpp::checked_int_cast<int>(value.intValue())); break;
+        case FIELD_M_Ack: pp->setM_Ack(omnetpp::checked_int_cast<int>(value.intValue())); break;
+        case FIELD_M_Sack: pp->setM_Sack(omnetpp::checked_int_cast<int>(value.intValue())); break;
+        case FIELD_M_FragIndex: pp->setM_FragIndex(omnetpp::checked_int_cast<int>(value.intValue())); break;
+        case FIELD_M_LastFragment: pp->setM_LastFragment(value.boolValue()); break;
+        case FIELD_M_Compressed: pp->setM_Compressed(value.boolValue()); break;
+        case FIELD_M_Credit: pp->setM_Credit(omnetpp::checked_int_cast<int>(value.intValue())); break;
+        case FIELD_M_Stream: pp->setM_Stream(omnetpp::checked_int_cast<int>(value.intValue())); break;
         default: throw omnetpp::cRuntimeError("Cannot set field %d of class 'CustomMessage'", field);
     }
 }
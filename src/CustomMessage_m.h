@@ -30,6 +30,13 @@ class CustomMessage;
  *     string M_Payload;
  *     char M_Trailer;
  *     int M_Type;
+ *     int M_Ack = -1;     // Piggybacked ACK (next expected seq_num), -1 if none
+ *     int M_Sack = 0;     // SACK bitmap: bit i set if frame ack+1+i is buffered at the receiver
+ *     int M_FragIndex = 0;            // Fragment number within the message
+ *     bool M_LastFragment = true;     // Set on the final (or only) fragment of a message
+ *     bool M_Compressed = false;      // Payload is LZ-compressed against the session dictionary
+ *     int M_Credit = -1;              // Receiver-advertised window in frames beyond the ACK, -1 if none
+ *     int M_Stream = 0;               // Logical channel (Node stream) of the frame
  * }
  * </pre>
  */
@@ -40,6 +47,13 @@ class CustomMessage : public ::omnetpp::cPacket
     omnetpp::opp_string M_Payload;
     char M_Trailer = 0;
     int M_Type = 0;
+    int M_Ack = -1;
+    int M_Sack = 0;
+    int M_FragIndex = 0;
+    bool M_LastFragment = true;
+    bool M_Compressed = false;
+    int M_Credit = -1;
+    int M_Stream = 0;
 
   private:
     void copy(const CustomMessage& other);
@@ -67,6 +81,27 @@ class CustomMessage : public ::omnetpp::cPacket
 
     virtual int getM_Type() const;
     virtual void setM_Type(int M_Type);
+
+    virtual int getM_Ack() const;
+    virtual void setM_Ack(int M_Ack);
+
+    virtual int getM_Sack() const;
+    virtual void setM_Sack(int M_Sack);
+
+    virtual int getM_FragIndex() const;
+    virtual void setM_FragIndex(int M_FragIndex);
+
+    virtual bool getM_LastFragment() const;
+    virtual void setM_LastFragment(bool M_LastFragment);
+
+    virtual bool getM_Compressed() const;
+    virtual void setM_Compressed(bool M_Compressed);
+
+    virtual int getM_Credit() const;
+    virtual void setM_Credit(int M_Credit);
+
+    virtual int getM_Stream() const;
+    virtual void setM_Stream(int M_Stream);
 };
 
 inline void doParsimPacking(omnetpp::cCommBuffer *b, const CustomMessage& obj) {obj.parsimPack(b);}
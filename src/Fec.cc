@@ -0,0 +1,438 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+#include "Fec.h"
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+FecMode parseFecMode(const std::string &name)
+{
+    if (name == "none")
+        return FEC_NONE;
+    if (name == "hamming")
+        return FEC_HAMMING;
+    if (name == "rs")
+        return FEC_REED_SOLOMON;
+    throw std::invalid_argument("Unknown FEC mode '" + name + "', expected none, hamming or rs");
+}
+
+// ---------------------------------------------------------------------------
+// Hamming(7,4) + overall parity
+//
+// Code byte layout: bits 0..6 hold Hamming positions 1..7 (p1 p2 d1 p3 d2 d3 d4),
+// bit 7 is the parity over all of them. Every code byte is XORed with a
+// non-codeword at distance >= 2 from all codewords, so no carrier byte is
+// ever 0x00, not even with one bit flipped.
+// ---------------------------------------------------------------------------
+
+static const unsigned char HAMMING_COSET = 0x0F;
+
+static unsigned char hammingEncodeTable[16];
+static signed char hammingDecodeTable[256]; // Data nibble, or -1 if uncorrectable
+static bool hammingCorrectedTable[256];
+static bool hammingTablesReady = false;
+
+static void initHammingTables()
+{
+    for (int n = 0; n < 16; n++)
+    {
+        int d1 = n & 1, d2 = (n >> 1) & 1, d3 = (n >> 2) & 1, d4 = (n >> 3) & 1;
+        int p1 = d1 ^ d2 ^ d4;
+        int p2 = d1 ^ d3 ^ d4;
+        int p3 = d2 ^ d3 ^ d4;
+        unsigned char code = p1 | p2 << 1 | d1 << 2 | p3 << 3 | d2 << 4 | d3 << 5 | d4 << 6;
+        code |= (__builtin_popcount(code) & 1) << 7;
+        hammingEncodeTable[n] = code;
+    }
+
+    for (int b = 0; b < 256; b++)
+    {
+        unsigned char code = b ^ HAMMING_COSET;
+        int syndrome = 0;
+        for (int pos = 1; pos <= 7; pos++)
+        {
+            if (code & (1 << (pos - 1)))
+                syndrome ^= pos;
+        }
+        bool parityError = __builtin_popcount(code) & 1;
+
+        hammingCorrectedTable[b] = false;
+        if (syndrome != 0 && !parityError)
+        {
+            hammingDecodeTable[b] = -1; // Two bit errors: detected, not correctable
+            continue;
+        }
+        if (parityError)
+        {
+            // Single error at 'syndrome' (0 means the parity bit itself)
+            code ^= syndrome ? 1 << (syndrome - 1) : 0x80;
+            hammingCorrectedTable[b] = true;
+        }
+        hammingDecodeTable[b] = ((code >> 2) & 1) | ((code >> 4) & 1) << 1 |
+                                ((code >> 5) & 1) << 2 | ((code >> 6) & 1) << 3;
+    }
+    hammingTablesReady = true;
+}
+
+std::string hammingEncode(const std::string &data)
+{
+    if (!hammingTablesReady)
+        initHammingTables();
+
+    std::string coded;
+    coded.reserve(data.size() * 2);
+    for (unsigned char c : data)
+    {
+        coded += (char)(hammingEncodeTable[c & 0x0F] ^ HAMMING_COSET);
+        coded += (char)(hammingEncodeTable[c >> 4] ^ HAMMING_COSET);
+    }
+    return coded;
+}
+
+bool hammingDecode(const std::string &coded, std::string &data, int &corrected)
+{
+    if (!hammingTablesReady)
+        initHammingTables();
+
+    corrected = 0;
+    data.clear();
+    if (coded.size() % 2 != 0)
+        return false;
+
+    data.reserve(coded.size() / 2);
+    for (size_t i = 0; i < coded.size(); i += 2)
+    {
+        unsigned char lo = coded[i], hi = coded[i + 1];
+        if (hammingDecodeTable[lo] < 0 || hammingDecodeTable[hi] < 0)
+            return false;
+        corrected += hammingCorrectedTable[lo] + hammingCorrectedTable[hi];
+        data += (char)(hammingDecodeTable[lo] | hammingDecodeTable[hi] << 4);
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Reed-Solomon over GF(2^8), primitive polynomial x^8+x^4+x^3+x^2+1 (0x11d)
+//
+// Data bytes travel six bits per carrier byte, 0xC0 | bits, least
+// significant first (as in HDLC framing), and each parity symbol as two
+// carrier bytes 0xC0 | nibble. Data sent raw would not do: any byte with a
+// single bit set, an LZ offset byte 0x80 say, turns into '\0' with one flip
+// and cuts the C-string payload short. A flip in a carrier's top bits is
+// ignored, one in the low bits damages at most two symbols. Payloads longer
+// than one codeword are split into blocks of 255 - paritySymbols data
+// bytes, each followed by its parity.
+// ---------------------------------------------------------------------------
+
+static unsigned char gfExp[512];
+static unsigned char gfLog[256];
+static bool gfTablesReady = false;
+
+static void initGfTables()
+{
+    int x = 1;
+    for (int i = 0; i < 255; i++)
+    {
+        gfExp[i] = x;
+        gfLog[x] = i;
+        x <<= 1;
+        if (x & 0x100)
+            x ^= 0x11d;
+    }
+    for (int i = 255; i < 512; i++)
+        gfExp[i] = gfExp[i - 255];
+    gfTablesReady = true;
+}
+
+static inline unsigned char gfMul(unsigned char a, unsigned char b)
+{
+    if (a == 0 || b == 0)
+        return 0;
+    return gfExp[gfLog[a] + gfLog[b]];
+}
+
+static inline unsigned char gfDiv(unsigned char a, unsigned char b)
+{
+    if (a == 0)
+        return 0;
+    return gfExp[(gfLog[a] + 255 - gfLog[b]) % 255];
+}
+
+static inline unsigned char gfPow(int e)
+{
+    return gfExp[((e % 255) + 255) % 255];
+}
+
+// Polynomials are stored highest degree first
+static unsigned char polyEval(const std::vector<unsigned char> &p, unsigned char x)
+{
+    unsigned char y = p[0];
+    for (size_t i = 1; i < p.size(); i++)
+        y = gfMul(y, x) ^ p[i];
+    return y;
+}
+
+static std::vector<unsigned char> rsGenerator(int nsym)
+{
+    std::vector<unsigned char> g(1, 1);
+    for (int i = 0; i < nsym; i++)
+    {
+        // g *= (x - alpha^i)
+        std::vector<unsigned char> next(g.size() + 1, 0);
+        for (size_t j = 0; j < g.size(); j++)
+        {
+            next[j] ^= g[j];
+            next[j + 1] ^= gfMul(g[j], gfPow(i));
+        }
+        g.swap(next);
+    }
+    return g;
+}
+
+static std::vector<unsigned char> rsParity(const unsigned char *msg, int len, int nsym)
+{
+    static std::vector<unsigned char> gen;
+    static int genSymbols = -1;
+    if (genSymbols != nsym)
+    {
+        gen = rsGenerator(nsym);
+        genSymbols = nsym;
+    }
+
+    // Remainder of msg(x) * x^nsym divided by g(x), by LFSR
+    std::vector<unsigned char> rem(nsym, 0);
+    for (int i = 0; i < len; i++)
+    {
+        unsigned char coef = (unsigned char)msg[i] ^ rem[0];
+        rem.erase(rem.begin());
+        rem.push_back(0);
+        if (coef != 0)
+        {
+            for (int j = 0; j < nsym; j++)
+                rem[j] ^= gfMul(gen[j + 1], coef);
+        }
+    }
+    return rem;
+}
+
+// Corrects codeword in place; returns number of corrected symbols or -1
+static int rsCorrect(std::vector<unsigned char> &cw, int nsym)
+{
+    int n = cw.size();
+
+    std::vector<unsigned char> synd(nsym);
+    bool clean = true;
+    for (int i = 0; i < nsym; i++)
+    {
+        synd[i] = polyEval(cw, gfPow(i));
+        clean = clean && synd[i] == 0;
+    }
+    if (clean)
+        return 0;
+
+    // Berlekamp-Massey: error locator, lowest degree first
+    std::vector<unsigned char> loc(1, 1), old(1, 1);
+    for (int i = 0; i < nsym; i++)
+    {
+        old.insert(old.begin(), 0);
+        unsigned char delta = synd[i];
+        for (size_t j = 1; j < loc.size(); j++)
+            delta ^= gfMul(loc[j], synd[i - j]);
+        if (delta != 0)
+        {
+            if (old.size() > loc.size())
+            {
+                std::vector<unsigned char> newLoc(old.size());
+                for (size_t j = 0; j < old.size(); j++)
+                    newLoc[j] = gfMul(old[j], delta);
+                unsigned char inv = gfDiv(1, delta);
+                old.assign(loc.size(), 0);
+                for (size_t j = 0; j < loc.size(); j++)
+                    old[j] = gfMul(loc[j], inv);
+                for (size_t j = 0; j < loc.size(); j++)
+                    newLoc[j] ^= loc[j];
+                loc.swap(newLoc);
+            }
+            else
+            {
+                for (size_t j = 0; j < old.size(); j++)
+                    loc[j] ^= gfMul(delta, old[j]);
+            }
+        }
+    }
+    while (loc.size() > 1 && loc.back() == 0)
+        loc.pop_back();
+    int errors = loc.size() - 1;
+    if (errors * 2 > nsym)
+        return -1;
+
+    // Chien search: position p (from the start) is in error if loc(alpha^-(n-1-p)) == 0
+    std::vector<int> positions;
+    for (int p = 0; p < n; p++)
+    {
+        unsigned char xinv = gfPow(-(n - 1 - p));
+        unsigned char y = 0;
+        for (int j = loc.size() - 1; j >= 0; j--)
+            y = gfMul(y, xinv) ^ loc[j];
+        if (y == 0)
+            positions.push_back(p);
+    }
+    if ((int)positions.size() != errors)
+        return -1;
+
+    // Forney: error evaluator omega(x) = S(x) * loc(x) mod x^nsym
+    std::vector<unsigned char> omega(nsym, 0);
+    for (int i = 0; i < nsym; i++)
+    {
+        for (size_t j = 0; j < loc.size() && j <= (size_t)i; j++)
+            omega[i] ^= gfMul(synd[i - j], loc[j]);
+    }
+    for (int p : positions)
+    {
+        unsigned char x = gfPow(n - 1 - p);
+        unsigned char xinv = gfDiv(1, x);
+
+        unsigned char num = 0;
+        for (int i = nsym - 1; i >= 0; i--)
+            num = gfMul(num, xinv) ^ omega[i];
+
+        // Formal derivative of loc keeps the odd-degree terms
+        unsigned char den = 0;
+        for (size_t j = 1; j < loc.size(); j += 2)
+            den ^= gfMul(loc[j], gfPow(-(int)(j - 1) * (n - 1 - p)));
+        if (den == 0)
+            return -1;
+
+        // First consecutive root is alpha^0, hence the extra factor x
+        cw[p] ^= gfMul(x, gfDiv(num, den));
+    }
+
+    for (int i = 0; i < nsym; i++)
+    {
+        if (polyEval(cw, gfPow(i)) != 0)
+            return -1;
+    }
+    return errors;
+}
+
+// Carrier bytes for len data bytes: ceil(8 * len / 6)
+static int dataCarriers(int len)
+{
+    return (4 * len + 2) / 3;
+}
+
+static void packCarriers(const unsigned char *data, int len, std::string &coded)
+{
+    unsigned bits = 0;
+    int count = 0;
+    for (int i = 0; i < len; i++)
+    {
+        bits |= (unsigned)data[i] << count;
+        count += 8;
+        while (count >= 6)
+        {
+            coded += (char)(0xC0 | (bits & 0x3F));
+            bits >>= 6;
+            count -= 6;
+        }
+    }
+    if (count > 0)
+        coded += (char)(0xC0 | (bits & 0x3F));
+}
+
+static void unpackCarriers(const char *carriers, int carrierCount, std::vector<unsigned char> &data)
+{
+    unsigned bits = 0;
+    int count = 0;
+    for (int i = 0; i < carrierCount; i++)
+    {
+        bits |= (unsigned)(carriers[i] & 0x3F) << count;
+        count += 6;
+        if (count >= 8)
+        {
+            data.push_back(bits & 0xFF);
+            bits >>= 8;
+            count -= 8;
+        }
+    }
+}
+
+std::string rsEncode(const std::string &data, int paritySymbols)
+{
+    if (!gfTablesReady)
+        initGfTables();
+
+    int blockData = 255 - paritySymbols;
+    std::string coded;
+    coded.reserve(dataCarriers(data.size()) + 2 * paritySymbols * (data.size() / blockData + 1));
+
+    for (size_t start = 0; start < data.size(); start += blockData)
+    {
+        int len = std::min<size_t>(blockData, data.size() - start);
+        const unsigned char *block = (const unsigned char *)data.data() + start;
+        std::vector<unsigned char> parity = rsParity(block, len, paritySymbols);
+
+        packCarriers(block, len, coded);
+        for (unsigned char p : parity)
+        {
+            coded += (char)(0xC0 | (p & 0x0F));
+            coded += (char)(0xC0 | (p >> 4));
+        }
+    }
+    return coded;
+}
+
+bool rsDecode(const std::string &coded, int paritySymbols, std::string &data, int &corrected)
+{
+    if (!gfTablesReady)
+        initGfTables();
+
+    corrected = 0;
+    data.clear();
+
+    int blockData = 255 - paritySymbols;
+    int carrierBytes = 2 * paritySymbols;
+    size_t pos = 0;
+    std::vector<unsigned char> cw;
+
+    while (pos < coded.size())
+    {
+        // Every block but the last is full; the last one's data length
+        // follows from the carriers left before its parity
+        int remaining = coded.size() - pos;
+        int carriers = std::min(dataCarriers(blockData), remaining - carrierBytes);
+        int len = std::min(blockData, 3 * carriers / 4);
+        if (carriers <= 0 || dataCarriers(len) != carriers)
+            return false;
+
+        cw.clear();
+        unpackCarriers(coded.data() + pos, carriers, cw);
+        for (int i = 0; i < paritySymbols; i++)
+        {
+            unsigned char lo = coded[pos + carriers + 2 * i] & 0x0F;
+            unsigned char hi = coded[pos + carriers + 2 * i + 1] & 0x0F;
+            cw.push_back(lo | hi << 4);
+        }
+
+        int fixed = rsCorrect(cw, paritySymbols);
+        if (fixed < 0)
+            return false;
+        corrected += fixed;
+
+        data.append(cw.begin(), cw.begin() + len);
+        pos += carriers + carrierBytes;
+    }
+    return true;
+}
@@ -0,0 +1,46 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __DATALINKLAYERNETWORK_FEC_H_
+#define __DATALINKLAYERNETWORK_FEC_H_
+
+#include <string>
+
+/**
+ * Forward error correction applied to the framed payload before it goes on
+ * the wire, so the receiver can repair bit errors without a NACK round trip.
+ *
+ * Encoded bytes never contain '\0', even after a single bit flip, because
+ * frames carry their payload in a C string (M_Payload).
+ */
+enum FecMode
+{
+    FEC_NONE,
+    FEC_HAMMING,      // Extended Hamming(7,4), corrects one bit per nibble
+    FEC_REED_SOLOMON  // Reed-Solomon over GF(256), corrects burst errors
+};
+
+FecMode parseFecMode(const std::string &name);
+
+// Hamming(7,4) plus an overall parity bit (SECDED), two code bytes per data byte
+std::string hammingEncode(const std::string &data);
+bool hammingDecode(const std::string &coded, std::string &data, int &corrected);
+
+// Systematic RS(255, 255 - paritySymbols), shortened; corrects paritySymbols / 2 bytes per block.
+// Data takes four carrier bytes per three, parity two per symbol
+std::string rsEncode(const std::string &data, int paritySymbols);
+bool rsDecode(const std::string &coded, int paritySymbols, std::string &data, int &corrected);
+
+#endif
@@ -0,0 +1,409 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+#include "Framing.h"
+#include "Crc.h"
+#include <cstdint>
+#include <stdexcept>
+
+FramingMode parseFramingMode(const std::string &name)
+{
+    if (name == "byte")
+        return FRAMING_BYTE;
+    if (name == "hdlc")
+        return FRAMING_HDLC;
+    if (name == "cobs")
+        return FRAMING_COBS;
+    throw std::invalid_argument("Unknown framing '" + name + "', expected byte, hdlc or cobs");
+}
+
+// ---------------------------------------------------------------------------
+// Byte stuffing
+// ---------------------------------------------------------------------------
+
+void byteStuff(std::string_view payload, std::pmr::string &framed)
+{
+    framed.clear();
+    framed.reserve(payload.size() + payload.size() / 8 + 2);
+    framed += '$'; // Start flag
+    for (char c : payload)
+    {
+        if (c == '$' || c == '/')
+        {
+            framed += '/'; // Escape special characters
+        }
+        framed += c;
+    }
+    framed += '$'; // End flag
+}
+
+bool byteUnstuff(const std::string &framed, std::string &payload)
+{
+    if (framed.size() < 2 || framed.front() != '$' || framed.back() != '$')
+        return false;
+
+    payload.clear();
+    payload.reserve(framed.size() - 2);
+    size_t end = framed.size() - 1;
+    for (size_t i = 1; i < end; ++i)
+    { // Skip start and end flags
+        char c = framed[i];
+        if (c == '/')
+        {
+            if (++i == end)
+                return false; // Escape swallowed the end flag
+            c = framed[i];
+        }
+        else if (c == '$')
+        {
+            return false; // Unescaped flag inside the frame
+        }
+        payload += c;
+    }
+    return true;
+}
+
+bool byteUnstuffCrc(const char *framed, std::string &payload, uint8_t &crc)
+{
+    payload.clear();
+    if (*framed != '$')
+        return false;
+    crc = crc8Update(CRC8_INIT, *framed++);
+
+    for (;;)
+    {
+        char c = *framed++;
+        if (c == '\0')
+            return false; // No end flag
+        crc = crc8Update(crc, c);
+        if (c == '$')
+            return *framed == '\0'; // End flag must close the frame
+        if (c == '/')
+        {
+            c = *framed++;
+            if (c == '\0')
+                return false;
+            crc = crc8Update(crc, c);
+        }
+        payload += c;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// HDLC bit stuffing
+//
+// Bits go out least significant first. The stuffer works on whole input
+// bytes through a table indexed by the run of ones carried in from the
+// previous byte, and passes a 64-bit word straight through when it contains
+// no run of five ones. Output bits collect in a 64-bit accumulator.
+// ---------------------------------------------------------------------------
+
+static const unsigned char HDLC_FLAG = 0x7E;
+
+namespace {
+
+struct HdlcTables
+{
+    // bits 0..15 stuffed bits, 16..23 their count (8..10), 24..31 run of ones after
+    uint32_t stuff[5][256];
+    // bits 0..7 data bits, 8..11 their count, 12..14 run of ones after, 15 set
+    // when a sixth one (closing flag) was seen; decoding stops there
+    uint32_t unstuff[6][256];
+
+    HdlcTables();
+};
+
+HdlcTables::HdlcTables()
+{
+    for (int runIn = 0; runIn < 5; runIn++)
+    {
+        for (int b = 0; b < 256; b++)
+        {
+            uint32_t bits = 0;
+            int count = 0;
+            int run = runIn;
+            for (int i = 0; i < 8; i++)
+            {
+                int bit = (b >> i) & 1;
+                bits |= bit << count++;
+                run = bit ? run + 1 : 0;
+                if (run == 5)
+                {
+                    count++; // Inserted zero
+                    run = 0;
+                }
+            }
+            stuff[runIn][b] = bits | count << 16 | run << 24;
+        }
+    }
+
+    for (int runIn = 0; runIn < 6; runIn++)
+    {
+        for (int b = 0; b < 256; b++)
+        {
+            uint32_t bits = 0;
+            int count = 0;
+            int run = runIn;
+            bool flag = false;
+            for (int i = 0; i < 8 && !flag; i++)
+            {
+                int bit = (b >> i) & 1;
+                if (run == 5)
+                {
+                    // After five ones a zero was stuffed; a one means a flag
+                    flag = bit;
+                    run = 0;
+                    continue;
+                }
+                bits |= bit << count++;
+                run = bit ? run + 1 : 0;
+            }
+            unstuff[runIn][b] = bits | count << 8 | run << 12 | flag << 15;
+        }
+    }
+}
+
+const HdlcTables &hdlcTables()
+{
+    static const HdlcTables tables;
+    return tables;
+}
+
+// Packs line bits into carrier bytes, six at a time
+class CarrierWriter
+{
+public:
+    explicit CarrierWriter(std::pmr::string &out) : out(out), acc(0), count(0) {}
+
+    void put(uint64_t bits, int n) // n <= 32
+    {
+        acc |= bits << count;
+        count += n;
+        while (count >= 6)
+        {
+            out += (char)(0xC0 | (acc & 0x3F));
+            acc >>= 6;
+            count -= 6;
+        }
+    }
+
+    void flush()
+    {
+        if (count > 0)
+            put(0, 6 - count);
+    }
+
+private:
+    std::pmr::string &out;
+    uint64_t acc;
+    int count;
+};
+
+inline int trailingOnes(uint64_t w)
+{
+    return ~w ? __builtin_ctzll(~w) : 64;
+}
+
+inline int leadingOnes(uint64_t w)
+{
+    return ~w ? __builtin_clzll(~w) : 64;
+}
+
+} // namespace
+
+void hdlcEncode(std::string_view payload, std::pmr::string &framed, size_t &bits)
+{
+    const HdlcTables &tables = hdlcTables();
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(payload.data());
+    size_t n = payload.size();
+
+    framed.clear();
+    framed.reserve((n * 8 * 6 / 5 + 16) / 6 + 2);
+    CarrierWriter writer(framed);
+    writer.put(HDLC_FLAG, 8);
+
+    size_t stuffedBits = 0;
+    int run = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        uint64_t word = 0;
+        for (int k = 0; k < 8; k++)
+            word |= (uint64_t)data[i + k] << (8 * k);
+
+        // Nothing to insert if no five ones in a row, including across the boundary
+        uint64_t fives = word & word >> 1 & word >> 2 & word >> 3 & word >> 4;
+        if (fives == 0 && run + trailingOnes(word) < 5)
+        {
+            writer.put(word & 0xFFFFFFFF, 32);
+            writer.put(word >> 32, 32);
+            stuffedBits += 64;
+            run = leadingOnes(word);
+            continue;
+        }
+
+        for (int k = 0; k < 8; k++)
+        {
+            uint32_t e = tables.stuff[run][data[i + k]];
+            int count = (e >> 16) & 0xFF;
+            writer.put(e & 0xFFFF, count);
+            stuffedBits += count;
+            run = e >> 24;
+        }
+    }
+    for (; i < n; i++)
+    {
+        uint32_t e = tables.stuff[run][data[i]];
+        int count = (e >> 16) & 0xFF;
+        writer.put(e & 0xFFFF, count);
+        stuffedBits += count;
+        run = e >> 24;
+    }
+
+    writer.put(HDLC_FLAG, 8);
+    writer.flush();
+    bits = stuffedBits + 16;
+}
+
+bool hdlcDecode(const std::string &framed, std::string &payload)
+{
+    const HdlcTables &tables = hdlcTables();
+
+    // Line bits back out of the carrier bytes
+    std::string line;
+    line.reserve(framed.size() * 6 / 8 + 1);
+    uint64_t acc = 0;
+    int count = 0;
+    for (unsigned char c : framed)
+    {
+        if ((c & 0xC0) != 0xC0)
+            return false;
+        acc |= (uint64_t)(c & 0x3F) << count;
+        count += 6;
+        if (count >= 8)
+        {
+            line += (char)(acc & 0xFF);
+            acc >>= 8;
+            count -= 8;
+        }
+    }
+    if (count > 0)
+        line += (char)(acc & 0xFF);
+    if (line.empty() || (unsigned char)line[0] != HDLC_FLAG)
+        return false;
+
+    payload.clear();
+    payload.reserve(line.size());
+    uint64_t out = 0;
+    int outBits = 0;
+    size_t total = 0;
+    int run = 0;
+    bool flag = false;
+    for (size_t i = 1; i < line.size() && !flag; i++)
+    {
+        uint32_t e = tables.unstuff[run][(unsigned char)line[i]];
+        int n = (e >> 8) & 0xF;
+        out |= (uint64_t)(e & 0xFF) << outBits;
+        outBits += n;
+        total += n;
+        run = (e >> 12) & 0x7;
+        flag = (e >> 15) & 1;
+        if (outBits >= 32)
+        {
+            for (int k = 0; k < 4; k++)
+            {
+                payload += (char)(out & 0xFF);
+                out >>= 8;
+            }
+            outBits -= 32;
+        }
+    }
+
+    // The closing flag's leading zero and five ones were taken as data
+    if (!flag || total < 6 || (total - 6) % 8 != 0)
+        return false;
+    for (; outBits > 0; outBits -= 8)
+    {
+        payload += (char)(out & 0xFF);
+        out >>= 8;
+    }
+    payload.resize((total - 6) / 8);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// COBS
+//
+// Consistent overhead byte stuffing with '$' in the role of the zero byte.
+// Code bytes run from 1 to 35 so they are never '\0' or '$' themselves; a
+// block holds up to 34 bytes.
+// ---------------------------------------------------------------------------
+
+static const unsigned char COBS_MAX_CODE = 35;
+
+void cobsEncode(std::string_view payload, std::pmr::string &framed)
+{
+    framed.clear();
+    framed.reserve(payload.size() + payload.size() / (COBS_MAX_CODE - 1) + 3);
+    framed += '$';
+
+    size_t codePos = framed.size();
+    unsigned char code = 1;
+    framed += (char)code;
+    for (char c : payload)
+    {
+        if (c != '$')
+        {
+            framed += c;
+            code++;
+        }
+        if (c == '$' || code == COBS_MAX_CODE)
+        {
+            framed[codePos] = (char)code;
+            codePos = framed.size();
+            code = 1;
+            framed += (char)code;
+        }
+    }
+    framed[codePos] = (char)code;
+
+    framed += '$';
+}
+
+bool cobsDecode(const std::string &framed, std::string &payload)
+{
+    if (framed.size() < 3 || framed.front() != '$' || framed.back() != '$')
+        return false;
+
+    payload.clear();
+    payload.reserve(framed.size());
+    size_t end = framed.size() - 1;
+    size_t i = 1;
+    while (i < end)
+    {
+        unsigned char code = framed[i++];
+        if (code == 0 || code > COBS_MAX_CODE || i + code - 1 > end)
+            return false;
+        for (int k = 1; k < code; k++)
+        {
+            char c = framed[i++];
+            if (c == '$')
+                return false;
+            payload += c;
+        }
+        if (code < COBS_MAX_CODE && i < end)
+            payload += '$';
+    }
+    return true;
+}
@@ -0,0 +1,55 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __DATALINKLAYERNETWORK_FRAMING_H_
+#define __DATALINKLAYERNETWORK_FRAMING_H_
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
+
+/**
+ * Frame delimiting schemes. Each encoder writes the framed payload as it is
+ * carried in M_Payload to a caller's (typically arena-backed) string, and reports the number of bits the frame occupies on
+ * a real line; decoders return false on a malformed frame.
+ *
+ * None of them produces '\0', because M_Payload is a C string.
+ */
+enum FramingMode
+{
+    FRAMING_BYTE,  // '$' flags, '/' escapes: up to 100% overhead
+    FRAMING_HDLC,  // 0x7E flags, a zero inserted after five ones: up to 20%
+    FRAMING_COBS   // '$' flags, '$'-free COBS blocks: at most one byte per 34
+};
+
+FramingMode parseFramingMode(const std::string &name);
+
+void byteStuff(std::string_view payload, std::pmr::string &framed);
+bool byteUnstuff(const std::string &framed, std::string &payload);
+
+// Receive fast path: one pass over a NUL-terminated wire payload that unstuffs
+// into payload (reusing its capacity) and computes the CRC-8 of the framed bytes
+bool byteUnstuffCrc(const char *framed, std::string &payload, uint8_t &crc);
+
+// Line bits are carried six per byte as 0xC0 | bits, least significant first
+void hdlcEncode(std::string_view payload, std::pmr::string &framed, size_t &bits);
+bool hdlcDecode(const std::string &framed, std::string &payload);
+
+void cobsEncode(std::string_view payload, std::pmr::string &framed);
+bool cobsDecode(const std::string &framed, std::string &payload);
+
+#endif
@@ -0,0 +1,174 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+#include "LogFormat.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+struct Bits8Table
+{
+    char digits[256][8];
+
+    constexpr Bits8Table() : digits()
+    {
+        for (int value = 0; value < 256; value++)
+            for (int bit = 0; bit < 8; bit++)
+                digits[value][bit] = (value >> (7 - bit)) & 1 ? '1' : '0';
+    }
+};
+
+constexpr Bits8Table bits8Table;
+
+} // namespace
+
+LogSink::LogSink(const char *path)
+    : file(std::fopen(path, "a")), buffer(new char[2 * FLUSH_THRESHOLD]),
+      capacity(2 * FLUSH_THRESHOLD), used(0), lineStart(0)
+{
+    // The sink's buffer is the only one between formatter and file
+    if (file)
+        std::setvbuf(file, nullptr, _IONBF, 0);
+}
+
+LogSink::LogSink(Writer writer)
+    : file(nullptr), writer(std::move(writer)), buffer(new char[2 * FLUSH_THRESHOLD]),
+      capacity(2 * FLUSH_THRESHOLD), used(0), lineStart(0)
+{
+}
+
+LogSink::~LogSink()
+{
+    flush();
+    if (file)
+        std::fclose(file);
+}
+
+void LogSink::flush()
+{
+    if (writer && lineStart > 0)
+        writer(buffer.get(), lineStart);
+    else if (file && lineStart > 0)
+        std::fwrite(buffer.get(), 1, lineStart, file);
+
+    // Keep an unfinished line at the front of the buffer
+    std::memmove(buffer.get(), buffer.get() + lineStart, used - lineStart);
+    used -= lineStart;
+    lineStart = 0;
+}
+
+char *LogSink::reserve(size_t n)
+{
+    // Completed lines go out in large writes
+    if (lineStart >= FLUSH_THRESHOLD)
+        flush();
+
+    if (used + n > capacity)
+    {
+        // Only a line longer than the whole buffer gets here
+        size_t grown = std::max(2 * capacity, used + n);
+        std::unique_ptr<char[]> larger(new char[grown]);
+        std::memcpy(larger.get(), buffer.get(), used);
+        buffer.swap(larger);
+        capacity = grown;
+    }
+    return buffer.get() + used;
+}
+
+LogSink &LogSink::text(std::string_view s)
+{
+    std::memcpy(reserve(s.size()), s.data(), s.size());
+    used += s.size();
+    return *this;
+}
+
+LogSink &LogSink::number(long value)
+{
+    char *p = reserve(24);
+    used = std::to_chars(p, p + 24, value).ptr - buffer.get();
+    return *this;
+}
+
+LogSink &LogSink::bits8(char value)
+{
+    std::memcpy(reserve(8), bits8Table.digits[(unsigned char)value], 8);
+    used += 8;
+    return *this;
+}
+
+LogSink &LogSink::fixed(double value)
+{
+    // Room for any double printed with six decimals
+    char *p = reserve(320);
+    used = std::to_chars(p, p + 320, value, std::chars_format::fixed, 6).ptr - buffer.get();
+    return *this;
+}
+
+std::string_view LogSink::endLine()
+{
+    *reserve(1) = '\n';
+    used++;
+    std::string_view line(buffer.get() + lineStart, used - lineStart - 1);
+    lineStart = used;
+    return line;
+}
+
+LogSink &writePrefix(LogSink &sink, const char *time, int node)
+{
+    return sink.text("At time [").text(time).text("], Node[").number(node).text("]: ");
+}
+
+void writeRecord(LogSink &sink, const LogRecord &record)
+{
+    switch (record.kind)
+    {
+    case LogRecord::SENT:
+        break;
+    case LogRecord::ACK:
+    case LogRecord::NACK:
+        sink.text(record.kind == LogRecord::ACK ? "Sending [ACK] with number [" : "Sending [NACK] with number [")
+            .number(record.number)
+            .text("], loss[No] ");
+        return;
+    case LogRecord::CHANNEL_ERROR:
+        sink.text("Introducing channel error with code =[").text(record.payload).text("]");
+        return;
+    case LogRecord::UPLOAD:
+        sink.text("Uploading payload=[").text(record.payload)
+            .text("] and seq_num=[").number(record.number)
+            .text("] to the network layer");
+        return;
+    case LogRecord::TIMEOUT:
+        sink.text("Timeout retransmission for frame ").number(record.number);
+        return;
+    }
+
+    sink.text("[sent] frame with seq_num=[").number(record.number)
+        .text("] and payload=[").text(record.payload)
+        .text("] and trailer=[").bits8(record.trailer);
+
+    // A lost, modified and delayed frame has always been logged without the space
+    bool lostModifiedDelayed = record.lost && record.modifiedBit >= 0 && record.duplicate == 0 && record.delayed;
+    sink.text(lostModifiedDelayed ? "] ,Modified [" : "] , Modified [").number(record.modifiedBit)
+        .text(record.lost ? "], Lost [Yes], Duplicate [" : "], Lost [No], Duplicate [").number(record.duplicate)
+        .text("], Delay [");
+    if (record.delayed)
+        sink.fixed(record.delay);
+    else
+        sink.text("0");
+    sink.text("]");
+}
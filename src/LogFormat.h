@@ -0,0 +1,97 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __DATALINKLAYERNETWORK_LOGFORMAT_H_
+#define __DATALINKLAYERNETWORK_LOGFORMAT_H_
+
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/**
+ * Buffered writer for output.txt. Lines are formatted straight into the
+ * sink's buffer (std::to_chars for numbers, a table for 8-bit binary
+ * strings) and reach the file in large writes, instead of going through
+ * string temporaries and a stream reopened for every line.
+ *
+ * One sink is shared by all nodes so lines keep their global event order.
+ * A sink built with a Writer hands each block of completed lines to it
+ * instead of a file, for callers that do their own I/O (udp/).
+ */
+class LogSink
+{
+public:
+    // Receives completed lines; the data is only valid during the call
+    typedef std::function<void(const char *data, size_t length)> Writer;
+
+    explicit LogSink(const char *path);
+    explicit LogSink(Writer writer);
+    ~LogSink();
+
+    bool isOpen() const { return file != nullptr || writer; }
+    void flush();
+
+    LogSink &text(std::string_view s);
+    LogSink &number(long value);
+    LogSink &bits8(char value);  // "01011010", as std::bitset<8>::to_string()
+    LogSink &fixed(double value); // Six decimals, as std::to_string(double)
+
+    // Terminates the line; the view stays valid until the next write
+    std::string_view endLine();
+
+private:
+    static const size_t FLUSH_THRESHOLD = 32 * 1024;
+
+    FILE *file;
+    Writer writer;
+    std::unique_ptr<char[]> buffer;
+    size_t capacity;
+    size_t used;
+    size_t lineStart;
+
+    char *reserve(size_t n);
+};
+
+// One output.txt line, without its "At time [..], Node[..]: " prefix
+struct LogRecord
+{
+    enum Kind
+    {
+        SENT,          // "[sent] frame with seq_num=[..] and payload=[..] ..."
+        ACK,           // "Sending [ACK] with number [..], loss[No] "
+        NACK,
+        CHANNEL_ERROR, // "Introducing channel error with code =[..]"
+        UPLOAD,        // "Uploading payload=[..] and seq_num=[..] to the network layer"
+        TIMEOUT        // "Timeout retransmission for frame .."
+    };
+
+    Kind kind = SENT;
+    int number = 0;       // seq_num, ACK/NACK number or frame slot
+    std::string payload;  // Payload or error code; keeps its capacity when reused
+    char trailer = 0;
+    int modifiedBit = -1; // -1 for an intact frame
+    bool lost = false;
+    int duplicate = 0;
+    bool delayed = false;
+    double delay = 0;
+};
+
+LogSink &writePrefix(LogSink &sink, const char *time, int node);
+void writeRecord(LogSink &sink, const LogRecord &record);
+
+#endif
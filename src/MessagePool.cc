@@ -0,0 +1,76 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+#include "MessagePool.h"
+#include <algorithm>
+
+#ifndef NDEBUG
+long MessagePool::outstanding = 0;
+#endif
+
+MessagePool::~MessagePool()
+{
+    for (CustomMessage *msg : idle)
+        delete msg;
+}
+
+CustomMessage *MessagePool::acquire(const char *name)
+{
+#ifndef NDEBUG
+    outstanding++;
+#endif
+    if (idle.empty())
+    {
+        allocated++;
+        return new CustomMessage(name);
+    }
+
+    reused++;
+    CustomMessage *msg = idle.back();
+    idle.pop_back();
+
+    // Everything a sender may have set, back to the defaults of CustomMessage.msg
+    msg->setName(name);
+    msg->setKind(0);
+    msg->setSchedulingPriority(0);
+    msg->setTimestamp(SIMTIME_ZERO);
+    msg->setBitLength(0);
+    msg->setBitError(false);
+    msg->setM_Header(0);
+    msg->setM_Payload("");
+    msg->setM_Trailer(0);
+    msg->setM_Type(0);
+    msg->setM_Ack(-1);
+    msg->setM_Sack(0);
+    msg->setM_FragIndex(0);
+    msg->setM_LastFragment(true);
+    msg->setM_Compressed(false);
+    msg->setM_Credit(-1);
+    msg->setM_Stream(0);
+    return msg;
+}
+
+void MessagePool::release(CustomMessage *msg)
+{
+#ifndef NDEBUG
+    ASSERT(!msg->isScheduled());
+    ASSERT(std::find(idle.begin(), idle.end(), msg) == idle.end());
+    outstanding--;
+#endif
+    delete msg->removeControlInfo();
+    if (idle.size() < capacity)
+        idle.push_back(msg);
+    else
+        delete msg;
+}
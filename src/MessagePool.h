@@ -0,0 +1,75 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __DATALINKLAYERNETWORK_MESSAGEPOOL_H_
+#define __DATALINKLAYERNETWORK_MESSAGEPOOL_H_
+
+#include <cstddef>
+#include <vector>
+#include "CustomMessage_m.h"
+
+using namespace omnetpp;
+
+/**
+ * Free list of CustomMessages, one per node. A frame the node has received
+ * goes back on the list instead of being deleted, and the node's next
+ * transmit() takes it from there, reset to the state of a new message. The
+ * messages on the list stay owned by the node that released them, so no
+ * object changes hands between modules outside send(). At most capacity
+ * messages are kept; a node that receives more frames than it sends (the
+ * data receiver when ACKs are coalesced) deletes the surplus.
+ *
+ * Debug builds (NDEBUG undefined) check that a message is released once and
+ * not while scheduled, and count the frames taken from any pool and not
+ * given back, see unreturned().
+ */
+class MessagePool
+{
+public:
+    explicit MessagePool(size_t capacity = 64) : capacity(capacity) {}
+    ~MessagePool();
+
+    MessagePool(const MessagePool &) = delete;
+    MessagePool &operator=(const MessagePool &) = delete;
+
+    // A message as new CustomMessage(name) would make it
+    CustomMessage *acquire(const char *name);
+
+    // Takes back a message the caller owns and is done with
+    void release(CustomMessage *msg);
+
+    long allocations() const { return allocated; }
+    long reuses() const { return reused; }
+
+#ifndef NDEBUG
+    // Frames taken and not yet released, over every pool since resetTally();
+    // at the end of a run these are the frames still in flight or dropped
+    // by a channel
+    static long unreturned() { return outstanding; }
+    static void resetTally() { outstanding = 0; }
+#endif
+
+private:
+    std::vector<CustomMessage *> idle;
+    size_t capacity;
+    long allocated = 0;
+    long reused = 0;
+
+#ifndef NDEBUG
+    static long outstanding;
+#endif
+};
+
+#endif
@@ -0,0 +1,250 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+#include "NetworkLayer.h"
+#include "CustomMessage_m.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+Define_Module(NetworkLayer);
+
+NetworkLayer::~NetworkLayer()
+{
+    cancelAndDelete(generateMsg);
+    cancelAndDelete(serveMsg);
+}
+
+void NetworkLayer::initialize()
+{
+    std::string kind = par("traffic").stdstringValue();
+    if (kind == "none")
+        traffic = TRAFFIC_NONE;
+    else if (kind == "poisson")
+        traffic = TRAFFIC_POISSON;
+    else if (kind == "fixed")
+        traffic = TRAFFIC_FIXED;
+    else if (kind == "onoff")
+        traffic = TRAFFIC_ONOFF;
+    else if (kind == "trace")
+        traffic = TRAFFIC_TRACE;
+    else
+        throw cRuntimeError("Unknown traffic '%s', expected \"poisson\", \"fixed\", \"onoff\", \"trace\" or \"none\"", kind.c_str());
+
+    rate = par("rate").doubleValue();
+    meanOnTime = par("meanOnTime").doubleValue();
+    meanOffTime = par("meanOffTime").doubleValue();
+    stopTime = par("stopTime").doubleValue();
+    errorCode = par("errorCode").stdstringValue();
+    if (errorCode.size() != 4)
+        throw cRuntimeError("errorCode '%s' is not a 4-digit code", errorCode.c_str());
+
+    delayVector.setName("delay");
+    delayStats.setName("delay");
+    backlog.setName("backlog");
+    serveMsg = new cMessage("Serve");
+
+    if (traffic == TRAFFIC_NONE)
+        return;
+    if (traffic != TRAFFIC_TRACE && rate <= 0)
+        throw cRuntimeError("traffic \"%s\" needs a positive rate", kind.c_str());
+
+    generateMsg = new cMessage("Generate");
+    simtime_t first = par("startTime").doubleValue();
+    if (traffic == TRAFFIC_TRACE)
+    {
+        trace.open(par("traceFile").stringValue(), std::ifstream::in);
+        if (!trace.is_open())
+            throw cRuntimeError("Cannot open traceFile '%s'", par("traceFile").stringValue());
+        if (!readTrace(first, nextTraceBytes))
+            return;
+    }
+    else if (traffic == TRAFFIC_ONOFF)
+    {
+        onUntil = first + exponential(meanOnTime);
+    }
+    scheduleAt(first, generateMsg);
+}
+
+void NetworkLayer::handleMessage(cMessage *msg)
+{
+    if (msg == generateMsg)
+    {
+        generate(traffic == TRAFFIC_TRACE ? nextTraceBytes : (int)par("payloadSize").intValue());
+        scheduleNext();
+        return;
+    }
+
+    if (msg == serveMsg)
+    {
+        CustomMessage *pkt = check_and_cast<CustomMessage *>(backlog.pop());
+        receive(pkt->getM_Payload(), pkt->getM_Stream());
+        delete pkt;
+        send(new cMessage("Ready"), "lowerOut");
+        if (!backlog.isEmpty())
+            scheduleAt(simTime() + par("serviceTime").doubleValue(), serveMsg);
+        return;
+    }
+
+    // A message the node below has delivered, served in arrival order
+    backlog.insert(msg);
+    maxBacklog = std::max(maxBacklog, backlog.getLength());
+    if (!serveMsg->isScheduled())
+        scheduleAt(simTime() + par("serviceTime").doubleValue(), serveMsg);
+}
+
+void NetworkLayer::generate(int bytes)
+{
+    int stream = par("stream").intValue();
+    if (stream < 0)
+        throw cRuntimeError("stream %d is negative", stream);
+    if (stream >= (int)sentByStream.size())
+        sentByStream.resize(stream + 1, 0);
+
+    // Creation time in raw units, so the sink's delay is exact
+    char header[64];
+    int length = snprintf(header, sizeof(header), "%s %ld %" PRId64,
+                          errorCode.c_str(), sentByStream[stream]++, simTime().raw());
+    std::string line(header, length);
+    size_t size = errorCode.size() + 1 + std::max(bytes, 0);
+    if (line.size() + 1 < size)
+    {
+        line += ' ';
+        line.append(size - line.size(), 'x');
+    }
+
+    CustomMessage *pkt = new CustomMessage("Packet");
+    pkt->setM_Payload(line.c_str());
+    pkt->setM_Stream(stream);
+    pkt->setByteLength(line.size() - errorCode.size() - 1);
+    bytesSent += pkt->getByteLength();
+    messagesSent++;
+    send(pkt, "lowerOut");
+}
+
+void NetworkLayer::scheduleNext()
+{
+    simtime_t next;
+    switch (traffic)
+    {
+    case TRAFFIC_POISSON:
+        next = simTime() + exponential(1 / rate);
+        break;
+    case TRAFFIC_FIXED:
+        next = simTime() + 1 / rate;
+        break;
+    case TRAFFIC_ONOFF:
+        next = simTime() + 1 / rate;
+        if (next > onUntil)
+        {
+            // Burst over: stay off, then start the next one
+            next = onUntil + exponential(meanOffTime);
+            onUntil = next + exponential(meanOnTime);
+        }
+        break;
+    case TRAFFIC_TRACE:
+        if (!readTrace(next, nextTraceBytes))
+            return;
+        break;
+    default:
+        return;
+    }
+    if (stopTime > SIMTIME_ZERO && next > stopTime)
+        return;
+    scheduleAt(next, generateMsg);
+}
+
+bool NetworkLayer::readTrace(simtime_t &time, int &bytes)
+{
+    double seconds;
+    if (!(trace >> seconds >> bytes))
+        return false;
+    time = seconds;
+    if (time < simTime())
+        throw cRuntimeError("traceFile: message at %gs is out of time order", seconds);
+    return true;
+}
+
+void NetworkLayer::receive(const char *payload, int stream)
+{
+    char *end;
+    long id = std::strtol(payload, &end, 10);
+    int64_t created = std::strtoll(end, &end, 10);
+    long bytes = std::strlen(payload);
+
+    if (stream >= (int)nextExpectedIds.size())
+        nextExpectedIds.resize(stream + 1, 0);
+    long &nextExpectedId = nextExpectedIds[stream];
+
+    if (id == nextExpectedId)
+    {
+        nextExpectedId++;
+        goodputBytes += bytes;
+    }
+    else if (id < nextExpectedId)
+    {
+        duplicates++;
+    }
+    else
+    {
+        EV << "Expected message " << nextExpectedId << " on stream " << stream << ", got " << id << "\n";
+        outOfOrder++;
+        nextExpectedId = id + 1;
+    }
+
+    if (messagesReceived++ == 0)
+        firstReceived = simTime();
+    lastReceived = simTime();
+    bytesReceived += bytes;
+
+    simtime_t delay = simTime() - SimTime::fromRaw(created);
+    delayVector.record(delay.dbl());
+    delayStats.collect(delay.dbl());
+    streamDelays[stream].collect(delay.dbl());
+}
+
+void NetworkLayer::finish()
+{
+    if (traffic != TRAFFIC_NONE)
+    {
+        recordScalar("messagesSent", messagesSent);
+        if (simTime() > SIMTIME_ZERO)
+            recordScalar("offeredLoad", bytesSent * 8 / simTime().dbl());
+    }
+
+    if (messagesReceived > 0)
+    {
+        recordScalar("messagesReceived", messagesReceived);
+        recordScalar("outOfOrder", outOfOrder);
+        recordScalar("duplicates", duplicates);
+        recordScalar("goodput", goodputBytes * 8 / simTime().dbl());
+        recordScalar("throughput", bytesReceived * 8 / simTime().dbl());
+        recordScalar("meanDelay", delayStats.getMean());
+        recordScalar("maxDelay", delayStats.getMax());
+        recordScalar("receivingTime", (lastReceived - firstReceived).dbl());
+        recordScalar("maxBacklog", maxBacklog);
+        if (streamDelays.size() > 1)
+        {
+            for (auto &entry : streamDelays)
+            {
+                std::string prefix = "stream" + std::to_string(entry.first) + ".";
+                recordScalar((prefix + "messagesReceived").c_str(), entry.second.getCount());
+                recordScalar((prefix + "meanDelay").c_str(), entry.second.getMean());
+                recordScalar((prefix + "maxDelay").c_str(), entry.second.getMax());
+            }
+        }
+    }
+}
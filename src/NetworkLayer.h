@@ -0,0 +1,106 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __DATALINKLAYERNET_NETWORKLAYER_H_
+#define __DATALINKLAYERNET_NETWORKLAYER_H_
+
+#include <omnetpp.h>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace omnetpp;
+
+/**
+ * Traffic source and sink on top of a Node, in place of its input file.
+ * The source hands the node one input line per generated message, "<error
+ * code> <id> <creation time> <filler>" padded to payloadSize bytes, with
+ * arrivals from the traffic parameter:
+ *
+ *   poisson  exponential gaps with mean 1/rate
+ *   fixed    a message every 1/rate seconds
+ *   onoff    bursts at a fixed rate; on and off periods are exponential
+ *   trace    "<time> <bytes>" lines of traceFile, in time order
+ *   none     sink only
+ *
+ * The sink consumes the node's delivered messages one at a time, taking
+ * serviceTime for each, checks that the ids come in order and records
+ * their delay from creation. After each message it sends the node a
+ * "Ready", which a node with a deliveryQueue waits for before handing up
+ * the next; other nodes push every message up at once and the sink's
+ * backlog grows. Offered load is recorded
+ * by the source, goodput by the sink, so sweeping rate finds the link's
+ * saturation throughput. Goodput counts only the messages that arrive
+ * in order; throughput also counts duplicates and messages that skip
+ * ahead.
+ *
+ * Each message goes out on the node stream drawn from the stream
+ * parameter. Ids count per stream, and the sink checks their order and
+ * records the delay of each stream on its own.
+ */
+class NetworkLayer : public cSimpleModule
+{
+private:
+    enum Traffic { TRAFFIC_NONE, TRAFFIC_POISSON, TRAFFIC_FIXED, TRAFFIC_ONOFF, TRAFFIC_TRACE };
+
+    Traffic traffic;
+    double rate;                 // Messages per second, while on
+    double meanOnTime;
+    double meanOffTime;
+    simtime_t stopTime;          // No messages after this, 0 = never
+    std::string errorCode;       // Arq error injection for every message
+    cMessage *generateMsg;       // Fires when the next message is due
+    simtime_t onUntil;           // End of the current "onoff" burst
+    std::ifstream trace;
+    int nextTraceBytes = 0;      // Size of the trace message generateMsg is for
+
+    // Source statistics
+    long messagesSent = 0;
+    std::vector<long> sentByStream;  // Next id on each stream
+    long bytesSent = 0;
+
+    // Sink
+    cQueue backlog;              // Delivered messages waiting for service
+    cMessage *serveMsg;          // Fires when the message in service is consumed
+    int maxBacklog = 0;
+    std::vector<long> nextExpectedIds; // By stream
+    long messagesReceived = 0;
+    long bytesReceived = 0;      // Every message, for throughput
+    long goodputBytes = 0;       // Messages with the next expected id only
+    long outOfOrder = 0;         // An id other than the next expected one
+    long duplicates = 0;         // An id already received
+    simtime_t firstReceived;
+    simtime_t lastReceived;
+    cOutVector delayVector;
+    cStdDev delayStats;
+    std::map<int, cStdDev> streamDelays;
+
+    void generate(int bytes);
+    void scheduleNext();
+    bool readTrace(simtime_t &time, int &bytes);
+    void receive(const char *payload, int stream);
+
+protected:
+    virtual void initialize() override;
+    virtual void handleMessage(cMessage *msg) override;
+    virtual void finish() override;
+
+public:
+    NetworkLayer() : generateMsg(nullptr), serveMsg(nullptr) {}
+    virtual ~NetworkLayer();
+};
+
+#endif
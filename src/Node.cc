@@ -14,15 +14,28 @@
 //
 #include "CustomMessage_m.h" // Include the generated header for CustomMessage
 #include "Node.h"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
 #include <string>
-#include <sstream>
-#include <bitset>
 
 Define_Module(Node);
 
-void Node::readFile(const char *filename)
+// Shared by all nodes so that lines stay in event order
+static LogSink &outputLog()
+{
+    static LogSink sink("output.txt");
+    return sink;
+}
+
+static TraceWriter &outputTrace()
+{
+    static TraceWriter trace("output.trace", SimTime::getScaleExp());
+    return trace;
+}
+
+void Node::readFile(const char *filename, std::vector<std::string> &lines)
 {
-    //    const char *fileName = par("inputFile").stringValue();
     std::ifstream file;
 
     file.open(filename, std::ifstream::in);
@@ -36,38 +49,118 @@ void Node::readFile(const char *filename)
     // Load messages from input file
     std::string line;
     while (std::getline(file, line))
-    {
-        std::string errorCode = line.substr(0, 4);
-        messages.push_back(line);
-    }
+        lines.push_back(line);
     file.close();
 }
 
 void Node::initialize()
 {
     // Get parameters from ini file
-    windowSize = 40;  //par("windowSize").intValue();
-    maxSeqNumber = 7;        // par("maxSeqNumber").intValue();
-    timeoutInterval = 10;    // par("timeoutInterval").doubleValue();
-    processingTime = 0.5;    // par("processingTime").doubleValue();
-    transmissionDelay = 1.0; // par("transmissionDelay").doubleValue();
-    errorDelay = 4;          // par("errorDelay").doubleValue();
-    duplicationDelay = 0.1;  // par("duplicationDelay").doubleValue();
-    lossProb = 0;            // par("lossProb").doubleValue();
-
-    timers.resize(maxSeqNumber, nullptr);
-
-    nextFrameToSend = 0;
-    expectedFrameToReceive = 0;
-    totalFramesAccepted = 0;
-    lastFrameTime = 0;
-
-    baseIndex = 0;
-    currentIndex = 0;
-    senderWindow.resize(maxSeqNumber);
-    ackReceived.resize(maxSeqNumber, false);
-    frameReceived.resize(maxSeqNumber, false);
-    receiverBuffer.resize(maxSeqNumber);
+    ArqConfig config;
+    config.windowSize = par("windowSize").intValue();
+    config.maxSeqNumber = par("maxSeqNumber").intValue();
+    config.timeoutInterval = par("timeoutInterval").doubleValue();
+    config.processingTime = par("processingTime").doubleValue();
+    config.errorDelay = par("errorDelay").doubleValue();
+    config.duplicationDelay = par("duplicationDelay").doubleValue();
+
+    binaryTrace = strcmp(par("traceFormat").stringValue(), "binary") == 0;
+    if (!binaryTrace && strcmp(par("traceFormat").stringValue(), "text") != 0)
+        throw cRuntimeError("Unknown traceFormat '%s'", par("traceFormat").stringValue());
+    if (binaryTrace ? !outputTrace().isOpen() : !outputLog().isOpen())
+        EV << "Error opening log file!\n";
+
+    // Retransmission timeout estimation (RFC 6298)
+    config.adaptiveTimeout = par("adaptiveTimeout").boolValue();
+    config.minTimeout = par("minTimeout").doubleValue();
+    config.maxTimeout = par("maxTimeout").doubleValue();
+    config.selectiveAck = par("selectiveAck").boolValue();
+
+    // Frame aggregation, fragmentation and reassembly
+    config.aggregation = par("aggregation").boolValue();
+    config.subframeCrc = par("subframeCrc").boolValue();
+    config.mtu = par("mtu").intValue();
+    config.fragmentation = par("fragmentation").boolValue();
+    config.maxReassemblyBytes = par("maxReassemblyBytes").intValue();
+    config.reassemblyTimeout = par("reassemblyTimeout").doubleValue();
+    config.compression = par("compression").boolValue();
+    config.fecParity = par("fecParity").intValue();
+
+    // Piggybacked and delayed ACKs
+    config.piggybackAcks = par("piggybackAcks").boolValue();
+    config.ackDelay = par("ackDelay").doubleValue();
+    config.ackEvery = par("ackEvery").intValue();
+    config.deliveryQueue = par("deliveryQueue").intValue();
+
+    // Logical channels and the scheduler that shares the link between them
+    int streamCount = par("streams").intValue();
+    if (streamCount < 1)
+        throw cRuntimeError("streams must be at least 1");
+    fairScheduler = strcmp(par("streamScheduler").stringValue(), "wfq") == 0;
+    if (!fairScheduler && strcmp(par("streamScheduler").stringValue(), "priority") != 0)
+        throw cRuntimeError("Unknown streamScheduler '%s'", par("streamScheduler").stringValue());
+    std::vector<double> weights = cStringTokenizer(par("streamWeights").stringValue()).asDoubleVector();
+    processingTime = config.processingTime;
+    sendSlot = new cMessage("SendSlot");
+
+    try
+    {
+        config.fecMode = parseFecMode(par("fecMode").stdstringValue());
+        config.framingMode = parseFramingMode(par("framing").stdstringValue());
+        for (int i = 0; i < streamCount; i++)
+        {
+            streams.emplace_back(new Stream(*this, i));
+            streams.back()->arq.reset(new ArqEndpoint(config, *streams.back(), *streams.back()));
+        }
+    }
+    catch (const std::invalid_argument &e)
+    {
+        throw cRuntimeError("%s", e.what());
+    }
+
+    hasUpperLayer = gate("upperOut")->isConnected();
+
+    calendarTimers = strcmp(par("timerQueue").stringValue(), "calendar") == 0;
+    if (!calendarTimers && strcmp(par("timerQueue").stringValue(), "fes") != 0)
+        throw cRuntimeError("Unknown timerQueue '%s'", par("timerQueue").stringValue());
+    if (calendarTimers)
+        calendarWakeup = new cMessage("Timers");
+
+    for (auto &stream : streams)
+    {
+        // Timer messages carry their stream as the message kind
+        stream->timers.resize(stream->arq->sequenceSpace(), nullptr);
+        stream->ackTimer = new cMessage("DelayedAck", stream->id);
+        stream->reassemblyTimer = new cMessage("ReassemblyTimeout", stream->id);
+        if (calendarTimers)
+            stream->runningTimers.resize(stream->arq->sequenceSpace() + 2);
+
+        if (stream->id < (int)weights.size())
+            stream->weight = weights[stream->id];
+        if (stream->weight <= 0)
+            throw cRuntimeError("streamWeights: stream %d has no positive weight", stream->id);
+
+        std::string prefix = streamCount > 1 ? "stream" + std::to_string(stream->id) + "." : "";
+        stream->rttVector.setName((prefix + "rtt").c_str());
+        stream->rtoVector.setName((prefix + "rto").c_str());
+    }
+
+#ifndef NDEBUG
+    MessagePool::resetTally();
+#endif
+}
+
+Node::~Node()
+{
+    for (auto &stream : streams)
+    {
+        for (cMessage *timer : stream->timers)
+            cancelAndDelete(timer);
+        cancelAndDelete(stream->ackTimer);
+        cancelAndDelete(stream->reassemblyTimer);
+    }
+    cancelAndDelete(sendSlot);
+    cancelAndDelete(calendarWakeup);
 }
 
 void Node::handleMessage(cMessage *msg)
@@ -76,9 +169,12 @@ void Node::handleMessage(cMessage *msg)
     {
         // Initialize transmission
         int me = getIndex();
-        readFile(me == 0 ? "input0.txt" : "input0.txt");
-        EV << "Node " << me << " initialized with " << messages.size() << " messages.\n";
-        sendFrames();
+        std::vector<std::string> lines;
+        // The coordinator's schedule may name a file for this session
+        const char *inputFile = msg->hasPar("inputFile") ? msg->par("inputFile").stringValue() : par("inputFile").stringValue();
+        readFile(*inputFile ? inputFile : me % 2 == 0 ? "input0.txt" : "input1.txt", lines);
+        EV << "Node " << me << " initialized with " << lines.size() << " messages.\n";
+        streams[0]->arq->start(std::move(lines)); // Input files feed stream 0
         delete msg;
     }
     else if (msg->isSelfMessage())
@@ -86,39 +182,92 @@ void Node::handleMessage(cMessage *msg)
         if (strcmp(msg->getName(), "SendNextFrame") == 0)
         {
             // send next frame
-            sendFrames();
+            streamOf(msg->getKind()).arq->sendFrames();
             delete msg;
         }
+        else if (msg == sendSlot)
+        {
+            sendNext();
+        }
+        else if (msg == calendarWakeup)
+        {
+            runCalendar();
+        }
+        else if (strcmp(msg->getName(), "ReassemblyTimeout") == 0)
+        {
+            streamOf(msg->getKind()).arq->reassemblyTimeout();
+        }
+        else if (strcmp(msg->getName(), "DelayedAck") == 0)
+        {
+            streamOf(msg->getKind()).arq->ackTimeout();
+        }
         else if (strcmp(msg->getName(), "Print") == 0)
         {
-
-            std::string str = prints.front();
-            prints.pop();
-            EV << "str: " << str << endl;
-            logEvent(str);
+            printNext();
+            delete msg;
         }
         else
         {
-            // Handle timeout
-            int seqNum = std::stoi(msg->getName());
-            handleTimeout(seqNum);
+            // Retransmission timeout; the timer is named after its frame index
+            Stream &stream = streamOf(msg->getKind());
+            int index = std::stoi(msg->getName());
+            stream.timers[index % stream.timers.size()] = nullptr;
             delete msg;
+            stream.arq->retransmitTimeout(index);
         }
     }
+    else if (msg->arrivedOn("upperIn") && strcmp(msg->getName(), "Ready") == 0)
+    {
+        // The network layer has taken a message and can take another
+        upperCredit++;
+        drainDeliveries();
+        delete msg;
+    }
+    else if (msg->arrivedOn("upperIn"))
+    {
+        // One input line from the network layer, queued behind the others
+        // of its stream
+        CustomMessage *pkt = check_and_cast<CustomMessage *>(msg);
+        Stream &stream = streamOf(pkt->getM_Stream());
+        if (streams.size() > 1)
+        {
+            // Sent when the scheduler gives the stream a slot
+            stream.arq->queue({pkt->getM_Payload()});
+            scheduleSend(stream, 0);
+        }
+        else
+        {
+            stream.arq->start({pkt->getM_Payload()});
+        }
+        delete msg;
+    }
     else if (CustomMessage *cmsg = dynamic_cast<CustomMessage *>(msg))
     {
-        switch (cmsg->getM_Type())
+        ArqFrame frame;
+        frame.name = cmsg->getName();
+        frame.type = cmsg->getM_Type();
+        frame.seqNum = cmsg->getM_Header();
+        frame.payload = cmsg->getM_Payload();
+        frame.trailer = cmsg->getM_Trailer();
+        frame.ack = cmsg->getM_Ack();
+        frame.sack = cmsg->getM_Sack();
+        frame.credit = cmsg->getM_Credit();
+        frame.fragIndex = cmsg->getM_FragIndex();
+        frame.lastFragment = cmsg->getM_LastFragment();
+        frame.compressed = cmsg->getM_Compressed();
+        frame.bitLength = cmsg->getBitLength();
+
+        EV << "-------------------------------------------------------\n";
+        try
         {
-        case FRAME_ACK:
-        case FRAME_NACK:
-            handleAck(msg);
-            break;
-        case FRAME_DATA:
-            receiveFrame(msg);
-            break;
-        default:
-            delete msg;
+            streamOf(cmsg->getM_Stream()).arq->receive(frame);
+        }
+        catch (const std::runtime_error &e)
+        {
+            throw cRuntimeError("%s", e.what());
         }
+        framePool.release(cmsg);
+        drainDeliveries();
     }
     else
     {
@@ -126,653 +275,456 @@ void Node::handleMessage(cMessage *msg)
     }
 }
 
-void Node::sendFrames()
+ArqTime Node::Stream::now() const
 {
-    if (currentIndex < messages.size() &&
-        currentIndex < baseIndex + windowSize &&
-        !ackReceived[currentIndex % maxSeqNumber])
-    {
-        std::string message = messages[currentIndex];
-
-        std::string payload = message.substr(5); // Skip error code
-        std::string errorCode = message.substr(0, 4);
-        std::string framedPayload = byteStuff(payload);
-        char crc = computeCRC(framedPayload);
+    return simTime().raw();
+}
 
-        CustomMessage *frame = new CustomMessage("DataFrame");
-        frame->setM_Header(currentIndex % maxSeqNumber); // TODO: Check if this is correct
-        frame->setM_Payload(framedPayload.c_str());
-        frame->setM_Trailer(crc);
-        frame->setM_Type(FRAME_DATA);
+ArqTime Node::Stream::fromSeconds(double seconds) const
+{
+    return SimTime(seconds).raw();
+}
 
-        logEvent("Introducing channel error with code =[" + errorCode + "]");
-        // Set timer
-        // if (timers[i] == nullptr)
-        // {
-        //     timers[i] = new cMessage(std::to_string(nextFrameToSend % windowSize).c_str());
-        //     scheduleAt(simTime() + timeoutInterval, timers[i]);
-        // }
+double Node::Stream::toSeconds(ArqTime time) const
+{
+    return SimTime::fromRaw(time).dbl();
+}
 
-        simulateErrors(frame, errorCode, 0);
+void Node::Stream::startTimer(ArqTimer timer, int index, double delay)
+{
+    node.startTimer(*this, timer, index, delay);
+}
 
-        // Update window state
-        senderWindow[currentIndex % maxSeqNumber] = payload;
-        currentIndex++;
+void Node::Stream::cancelTimer(ArqTimer timer, int index)
+{
+    node.cancelTimer(*this, timer, index);
+}
 
-        // Schedule next frame after processing delay
-        if (currentIndex < messages.size())
-        {
-            scheduleAt(simTime() + processingTime, new cMessage("SendNextFrame"));
-        }
-    }
+void Node::Stream::scheduleSend(double delay)
+{
+    node.scheduleSend(*this, delay);
 }
 
-void Node::handleAck(cMessage *msg)
+void Node::Stream::transmit(const ArqFrame &frame, double delay)
 {
-    CustomMessage *ackMsg = check_and_cast<CustomMessage *>(msg);
-    int ackNum = ackMsg->getM_Header();
+    node.transmit(*this, frame, delay);
+}
 
-    if (ackMsg->getM_Type() == FRAME_NACK)
-    {
-        if (ackNum >= baseIndex && ackNum < currentIndex)
-        {
-            // Cancel existing timer
-            if (timers[ackNum % maxSeqNumber])
-            {
-                cancelEvent(timers[ackNum % maxSeqNumber]);
-                delete timers[ackNum % maxSeqNumber];
-                timers[ackNum % maxSeqNumber] = nullptr;
-            }
+void Node::Stream::deliver(std::string_view message, int seqNum)
+{
+    node.deliver(*this, message, seqNum);
+}
 
-            // Retransmit frame
-            std::string framedPayload = byteStuff(senderWindow[ackNum % windowSize]);
-            CustomMessage *retransFrame = new CustomMessage("RetransFrame");
-            retransFrame->setM_Header(ackNum);
-            retransFrame->setM_Payload(framedPayload.c_str());
-            retransFrame->setM_Trailer(computeCRC(framedPayload));
-            retransFrame->setM_Type(FRAME_DATA);
+void Node::Stream::log(const LogRecord &record)
+{
+    node.logRecord(record);
+}
 
-            sendDelayed(retransFrame, processingTime + transmissionDelay, "out");
+void Node::Stream::logDelayed(const LogRecord &record, double delay)
+{
+    node.logDelayed(record, delay);
+}
 
-            // Set new timer
-            timers[ackNum % maxSeqNumber] = new cMessage(std::to_string(ackNum).c_str());
-            scheduleAt(simTime() + timeoutInterval, timers[ackNum % maxSeqNumber]);
-        }
-    }
-    else
-    {
-        // Process cumulative ACK
-        if (ackNum >= baseIndex)
-        {
-            // Clear all frames up to ackNum
-            for (int i = baseIndex; i <= ackNum; i++)
-            {
-                if (timers[i % maxSeqNumber])
-                {
-                    cancelEvent(timers[i % maxSeqNumber]);
-                    delete timers[i % maxSeqNumber];
-                    timers[i % maxSeqNumber] = nullptr;
-                }
-                ackReceived[i % maxSeqNumber] = false;
-                senderWindow[i % maxSeqNumber].clear();
-            }
+void Node::Stream::note(const char *text)
+{
+    EV << text << "\n";
+}
 
-            // Slide window
-            baseIndex = ackNum + 1;
+void Node::Stream::rttSample(double rtt)
+{
+    rttVector.record(rtt);
+}
 
-            // Try sending new frames
-            scheduleAt(simTime() + processingTime, new cMessage("SendNextFrame"));
-        }
-    }
-    delete msg;
-}
-
-// void Node::receiveFrame(cMessage *msg)
-// {
-//     CustomMessage *frame = check_and_cast<CustomMessage *>(msg);
-//     int rcvSeqNum = frame->getM_Header();
-//     std::string payload = frame->getM_Payload();
-//     char crc = frame->getM_Trailer();
-
-//     bool isCorerctSeqnum = false;
-
-//     for (size_t i = 0; i < windowSize; i++)
-//     {
-//         if (rcvSeqNum == (baseIndex + i) % (maxSeqNumber + 1))
-//         {
-//             isCorerctSeqnum = true;
-//             break;
-//         }
-//     }
-
-//     // Check if frame is within window bounds
-//     if (isCorerctSeqnum)
-//     {
-//         // Check CRC
-//         if (checkCRC(payload, crc))
-//         {
-//             // Buffer the frame
-//             receiverBuffer[baseIndex] = byteUnstuff(payload);
-//             frameReceived[baseIndex] = true; // Mark frame as received
-
-//             int temp = baseIndex;
-//             while (frameReceived[baseIndex])
-//             {
-//                 // Process and deliver to network layer
-//                 logEvent("Uploading payload=[" +
-//                          receiverBuffer[baseIndex] +
-//                          "] and seq_num=[" + std::to_string(baseIndex) +
-//                          "] to the network layer");
-
-//                 // Clear buffer and mark as unreceived
-//                 receiverBuffer[baseIndex] = "";
-//                 frameReceived[baseIndex] = false;
-//                 baseIndex++;
-//             }
-
-//             // Send cumulative ACK for highest consecutive frame
-//             if (baseIndex != temp)
-//             {
-//                 CustomMessage *ack = new CustomMessage("ACK");
-//                 ack->setM_Header(baseIndex); // ACK all frames up to this
-//                 ack->setM_Type(FRAME_ACK);
-//                 sendDelayed(ack, processingTime + transmissionDelay, "out");
-
-//                 prints.push("Sending [ACK] with number [" +
-//                             std::to_string(baseIndex) +
-//                             "], loss[No] ");
-
-//                 scheduleAt(simTime() + processingTime, new cMessage("Print"));
-
-//                 expectedFrameToReceive = baseIndex;
-//             }
-//         }
-//         else
-//         {
-//             EV << "Invalid CRC\n";
-//             // Invalid CRC
-//             if (rcvSeqNum == expectedFrameToReceive)
-//             {
-//                 // Send NACK for expected frame
-//                 CustomMessage *nack = new CustomMessage("NACK");
-//                 nack->setM_Header(rcvSeqNum);
-//                 nack->setM_Type(FRAME_NACK);
-//                 sendDelayed(nack, processingTime + transmissionDelay, "out");
-
-//                 prints.push("Sending [NACK] with number [" +
-//                             std::to_string(expectedFrameToReceive) +
-//                             "], loss[No] ");
-//                 scheduleAt(simTime() + processingTime, new cMessage("Print"));
-//             }
-//             // Else: Silent discard for out-of-sequence corrupt frames
-//         }
-//     }
-//     // Else: Frame outside window - silently discard
-
-//     delete msg;
-// }
-
-void Node::receiveFrame(cMessage *msg)
-{
-    CustomMessage *frame = check_and_cast<CustomMessage *>(msg);
-    int rcvSeqNum = frame->getM_Header();
-    std::string payload = frame->getM_Payload();
-    char crc = frame->getM_Trailer();
-
-    bool isCorerctSeqnum = false;
-
-    for (size_t i = 0; i < windowSize; i++)
-    {
-        if (rcvSeqNum == (baseIndex + i) % (maxSeqNumber + 1))
-        {
-            isCorerctSeqnum = true;
-            break;
-        }
-    }
-    // Check if frame is within window bounds
-    if (true)
-    {
-        EV << "-------------------------------------------------------\n";
-        // Check CRC
-        if (checkCRC(payload, crc))
-        {
-            // Buffer the frame
-            receiverBuffer[rcvSeqNum % maxSeqNumber] = byteUnstuff(payload);
-            frameReceived[rcvSeqNum % maxSeqNumber] = true; // Mark frame as received
+void Node::Stream::rtoChanged(double rto)
+{
+    rtoVector.record(rto);
+}
 
-            // If it's the expected frame
-            int highestConsecutive = expectedFrameToReceive;
+Node::Stream &Node::streamOf(int index)
+{
+    if (index < 0 || index >= (int)streams.size())
+        throw cRuntimeError("No stream %d, the node has %d (streams must match on both ends)", index, (int)streams.size());
+    return *streams[index];
+}
 
-            while (frameReceived[highestConsecutive % maxSeqNumber])
-            {
-                // Process and deliver to network layer
-                logEvent("Uploading payload=[" +
-                         receiverBuffer[highestConsecutive % maxSeqNumber] +
-                         "] and seq_num=[" + std::to_string(highestConsecutive) +
-                         "] to the network layer");
-
-                // Clear buffer and mark as unreceived
-                receiverBuffer[highestConsecutive % maxSeqNumber] = "";
-                frameReceived[highestConsecutive % maxSeqNumber] = false;
-                highestConsecutive++;
-            }
+cMessage *&Node::timerMessage(Stream &stream, ArqTimer timer, int index)
+{
+    switch (timer)
+    {
+    case TIMER_ACK:
+        return stream.ackTimer;
+    case TIMER_REASSEMBLY:
+        return stream.reassemblyTimer;
+    default:
+        return stream.timers[index % stream.timers.size()];
+    }
+}
 
-            // Send cumulative ACK for highest consecutive frame
-            if (highestConsecutive > expectedFrameToReceive)
-            {
-                CustomMessage *ack = new CustomMessage("ACK");
-                ack->setM_Header(highestConsecutive); // ACK all frames up to this
-                ack->setM_Type(FRAME_ACK);
-                sendDelayed(ack, processingTime + transmissionDelay, "out");
+size_t Node::timerSlot(const Stream &stream, ArqTimer timer, int index) const
+{
+    switch (timer)
+    {
+    case TIMER_ACK:
+        return stream.timers.size();
+    case TIMER_REASSEMBLY:
+        return stream.timers.size() + 1;
+    default:
+        return index % stream.timers.size();
+    }
+}
 
-                prints.push("Sending [ACK] with number [" +
-                            std::to_string(highestConsecutive) +
-                            "], loss[No] ");
+void Node::startTimer(Stream &stream, ArqTimer timer, int index, double delay)
+{
+    if (calendarTimers)
+    {
+        cancelTimer(stream, timer, index);
+        stream.runningTimers[timerSlot(stream, timer, index)] = pushCalendar(timer, stream.id, index, delay);
+        return;
+    }
 
-                scheduleAt(simTime() + processingTime, new cMessage("Print"));
+    cMessage *&msg = timerMessage(stream, timer, index);
+    if (timer == TIMER_RETRANSMIT)
+    {
+        // A fresh message per frame, named after its index for the timeout handler
+        cancelAndDelete(msg);
+        msg = new cMessage(std::to_string(index).c_str(), stream.id);
+    }
+    else if (msg->isScheduled())
+    {
+        cancelEvent(msg);
+    }
+    scheduleAt(simTime() + delay, msg);
+}
 
-                expectedFrameToReceive = highestConsecutive;
-            }
-        }
-        else
-        {
-            EV << "Invalid CRC\n";
-            // Invalid CRC
-            // if (rcvSeqNum == expectedFrameToReceive)
-            // {
-            // Send NACK for expected frame
-            CustomMessage *nack = new CustomMessage("NACK");
-            nack->setM_Header(rcvSeqNum);
-            nack->setM_Type(FRAME_NACK);
-            sendDelayed(nack, processingTime + transmissionDelay, "out");
-
-            prints.push("Sending [NACK] with number [" +
-                        std::to_string(rcvSeqNum) +
-                        "], loss[No] ");
-
-            scheduleAt(simTime() + processingTime, new cMessage("Print"));
-            // }
-            // Else: Silent discard for out-of-sequence corrupt frames
-        }
+void Node::cancelTimer(Stream &stream, ArqTimer timer, int index)
+{
+    if (calendarTimers)
+    {
+        // The wakeup stays where it is; if it was for this timer it finds nothing due
+        CalendarTimer &running = stream.runningTimers[timerSlot(stream, timer, index)];
+        if (running.at >= 0)
+            calendar.remove(running);
+        running.at = -1;
+        return;
     }
-    // Else: Frame outside window - silently discard
 
-    delete msg;
+    cMessage *&msg = timerMessage(stream, timer, index);
+    if (timer == TIMER_RETRANSMIT)
+    {
+        cancelAndDelete(msg);
+        msg = nullptr;
+    }
+    else if (msg->isScheduled())
+    {
+        cancelEvent(msg);
+    }
 }
 
-std::string Node::byteStuff(const std::string &payload)
+void Node::scheduleSend(Stream &stream, double delay)
 {
-    std::ostringstream framed;
-    framed << '$'; // Start flag
-    for (char c : payload)
+    if (streams.size() > 1)
     {
-        if (c == '$' || c == '/')
-        {
-            framed << '/'; // Escape special characters
-        }
-        framed << c;
+        // The streams share the link: wait for a send slot
+        stream.wantsSend = true;
+        if (!sendSlot->isScheduled())
+            scheduleAt(simTime() + delay, sendSlot);
+    }
+    else if (calendarTimers)
+    {
+        pushCalendar(CALENDAR_SEND, stream.id, 0, delay);
+    }
+    else
+    {
+        scheduleAt(simTime() + delay, new cMessage("SendNextFrame", stream.id));
     }
-    framed << '$'; // End flag
-    return framed.str();
 }
 
-std::string Node::byteUnstuff(const std::string &framed)
+void Node::sendNext()
 {
-    std::ostringstream payload;
-    bool escape = false;
-    for (size_t i = 1; i < framed.size() - 1; ++i)
-    { // Skip start and end flags
-        if (framed[i] == '/')
+    // "priority" gives the slot to the lowest-numbered stream with a frame
+    // to send. "wfq" is start-time fair queueing by frames: each frame is
+    // tagged with the later of the virtual time and its stream's previous
+    // tag plus 1 / weight, the earliest tag goes first, and a stream that
+    // was idle starts again at the virtual time instead of catching up.
+    Stream *next = nullptr;
+    double nextStart = 0;
+    for (auto &stream : streams)
+    {
+        if (!stream->wantsSend)
+            continue;
+        if (!stream->arq->readyToSend())
         {
-            escape = true;
+            // Window or credit closed; the endpoint asks again once it opens
+            stream->wantsSend = false;
+            stream->arq->sendFrames();
             continue;
         }
-        payload << framed[i];
-        escape = false;
+        double start = std::max(virtualTime, stream->finishTag);
+        if (!next || (fairScheduler && start < nextStart))
+        {
+            next = stream.get();
+            nextStart = start;
+        }
+    }
+
+    if (next)
+    {
+        next->wantsSend = false;
+        virtualTime = nextStart;
+        next->finishTag = nextStart + 1 / next->weight;
+        next->arq->sendFrames(); // Asks for another slot if it has more to send
+    }
+
+    // Streams still waiting get the next slot
+    for (auto &stream : streams)
+    {
+        if (stream->wantsSend && !sendSlot->isScheduled())
+            scheduleAt(simTime() + processingTime, sendSlot);
     }
-    return payload.str();
 }
 
-char Node::computeCRC(const std::string &data)
+Node::CalendarTimer Node::pushCalendar(int kind, int stream, int index, double delay)
 {
-    unsigned char polynomial = 0x07; // x8 + x2 + x + 1
-    unsigned char crc = 0xFF;        // Initialize with all 1's
+    CalendarTimer timer;
+    timer.at = (simTime() + delay).raw();
+    timer.order = calendarOrder++;
+    timer.kind = kind;
+    timer.stream = stream;
+    timer.index = index;
+    calendar.push(timer);
+
+    // Only a timer due before the wakeup moves it
+    if (!inCalendar && (!calendarWakeup->isScheduled() || timer.at < calendarWakeup->getArrivalTime().raw()))
+        rescheduleWakeup();
+    return timer;
+}
 
-    for (unsigned char c : data)
+void Node::runCalendar()
+{
+    inCalendar = true;
+    ArqTime now = simTime().raw();
+    while (!calendar.empty() && calendar.top().at <= now)
     {
-        crc ^= c;
-        for (int i = 0; i < 8; i++)
+        CalendarTimer timer = calendar.top();
+        calendar.pop();
+        Stream &stream = *streams[timer.stream];
+        switch (timer.kind)
         {
-            crc = (crc & 0x80) ? ((crc << 1) ^ polynomial) : (crc << 1);
+        case CALENDAR_SEND:
+            stream.arq->sendFrames();
+            break;
+        case CALENDAR_PRINT:
+            printNext();
+            break;
+        case TIMER_RETRANSMIT:
+            stream.runningTimers[timerSlot(stream, TIMER_RETRANSMIT, timer.index)].at = -1;
+            stream.arq->retransmitTimeout(timer.index);
+            break;
+        case TIMER_ACK:
+            stream.runningTimers[timerSlot(stream, TIMER_ACK, 0)].at = -1;
+            stream.arq->ackTimeout();
+            break;
+        case TIMER_REASSEMBLY:
+            stream.runningTimers[timerSlot(stream, TIMER_REASSEMBLY, 0)].at = -1;
+            stream.arq->reassemblyTimeout();
+            break;
         }
     }
-    return static_cast<char>(crc);
+    inCalendar = false;
+    rescheduleWakeup();
 }
 
-bool Node::checkCRC(const std::string &data, char crc)
+void Node::rescheduleWakeup()
 {
-    EV << "Checking CRC for data: " << data << endl;
-    unsigned char receivedCRC = static_cast<unsigned char>(crc);
-    unsigned char calculatedCRC = static_cast<unsigned char>(computeCRC(data));
-    EV << "Calculated CRC: " << (int)calculatedCRC << ", Received CRC: " << (int)receivedCRC << endl;
-    return calculatedCRC == receivedCRC;
+    if (calendar.empty())
+        return;
+    simtime_t at = SimTime::fromRaw(calendar.top().at);
+    if (calendarWakeup->isScheduled())
+    {
+        if (calendarWakeup->getArrivalTime() == at)
+            return;
+        cancelEvent(calendarWakeup);
+    }
+    scheduleAt(at, calendarWakeup);
 }
 
-void Node::handleTimeout(int seqNum)
+void Node::transmit(Stream &stream, const ArqFrame &frame, double delay)
 {
-    // Create error-free retransmission
-    CustomMessage *frame = new CustomMessage("DataFrame");
-    frame->setM_Header(seqNum);
-
-    std::string payload = senderWindow[seqNum % windowSize];
-    std::string framedPayload = byteStuff(payload);
-    char crc = computeCRC(framedPayload);
-
-    frame->setM_Payload(framedPayload.c_str());
-    frame->setM_Trailer(crc);
-    frame->setM_Type(FRAME_DATA);
-
-    logEvent("Timeout retransmission for frame " + std::to_string(seqNum));
-
-    // Send with additional processing delay
-    sendDelayed(frame, processingTime + 0.001, "out");
-
-    // Reset timer
-    timers[seqNum % windowSize] = new cMessage(std::to_string(seqNum).c_str());
-    scheduleAt(simTime() + timeoutInterval, timers[seqNum % windowSize]);
+    CustomMessage *msg = framePool.acquire(frame.name);
+    msg->setM_Header(frame.seqNum);
+    msg->setM_Payload(frame.payload);
+    msg->setM_Trailer(frame.trailer);
+    msg->setM_Type(frame.type);
+    msg->setM_Ack(frame.ack);
+    msg->setM_Sack(frame.sack);
+    msg->setM_Credit(frame.credit);
+    msg->setM_FragIndex(frame.fragIndex);
+    msg->setM_LastFragment(frame.lastFragment);
+    msg->setM_Compressed(frame.compressed);
+    msg->setM_Stream(stream.id);
+    msg->setBitLength(frame.bitLength + (streams.size() > 1 ? 8 : 0)); // Stream number in the header
+    sendDelayed(msg, delay, "out");
 }
 
-void Node::simulateErrors(CustomMessage *frame, const std::string &errorCode, int i)
+void Node::deliver(Stream &stream, std::string_view message, int seqNum)
 {
-    std::string payload = frame->getM_Payload();
-
-    char trailer = frame->getM_Trailer();
-    char seqNum = frame->getM_Header();
-    bool modified = false;
-    int bitPosition = 0;
-    std::string state = "";
-    // Case "0000": No error
-    if (errorCode == "0000")
+    logEvent(LogRecord::UPLOAD, seqNum, message);
+    if (hasUpperLayer)
     {
-        sendDelayed(frame, processingTime + transmissionDelay, "out");
-        state = "[sent] frame with seq_num=[" + std::to_string(seqNum) +
-                "] and payload=[" + payload +
-                "] and trailer=[" + std::bitset<8>(trailer).to_string() +
-                "] , Modified [-1], Lost [No], Duplicate [0], Delay [0]";
-
-        prints.push(state);
-        scheduleAt(simTime() + processingTime, new cMessage("Print"));
+        CustomMessage *pkt = new CustomMessage("Packet");
+        pkt->setM_Payload(std::string(message).c_str());
+        pkt->setM_Stream(stream.id);
+        pkt->setByteLength(message.size());
+        send(pkt, "upperOut");
     }
-    // Case "0001": Delay only
-    else if (errorCode == "0001")
-    {
-        sendDelayed(frame, processingTime + transmissionDelay + errorDelay, "out");
-        state = "[sent] frame with seq_num=[" + std::to_string(seqNum) +
-                "] and payload=[" + payload +
-                "] and trailer=[" + std::bitset<8>(trailer).to_string() +
-                "] , Modified [-1], Lost [No], Duplicate [0], Delay [" + std::to_string(errorDelay) + "]";
+}
 
-        prints.push(state);
-        scheduleAt(simTime() + processingTime, new cMessage("Print"));
-    }
-    // Case "0010": Duplication without delay
-    else if (errorCode == "0010")
+void Node::drainDeliveries()
+{
+    // Without a network layer above, messages are consumed as they arrive;
+    // with one, lower-numbered streams are handed up first
+    for (auto &stream : streams)
     {
-        CustomMessage *duplicate = frame->dup();
-        sendDelayed(frame, processingTime + transmissionDelay, "out");
-        sendDelayed(duplicate, processingTime + transmissionDelay + duplicationDelay, "out");
-        state = "[sent] frame with seq_num=[" + std::to_string(seqNum) +
-                "] and payload=[" + payload +
-                "] and trailer=[" + std::bitset<8>(trailer).to_string() +
-                "] , Modified [-1], Lost [No], Duplicate [1], Delay [0]";
-        prints.push(state);
-        scheduleAt(simTime() + processingTime, new cMessage("Print"));
-
-        std::string state2 = "[sent] frame with seq_num=[" + std::to_string(seqNum) +
-                             "] and payload=[" + payload +
-                             "] and trailer=[" + std::bitset<8>(trailer).to_string() +
-                             "] , Modified [-1], Lost [No], Duplicate [2], Delay [0]";
-
-        prints.push(state2);
-        scheduleAt(simTime() + processingTime + duplicationDelay, new cMessage("Print"));
+        while (stream->arq->pendingDeliveries() > 0 && (!hasUpperLayer || upperCredit > 0))
+        {
+            if (hasUpperLayer)
+                upperCredit--;
+            try
+            {
+                stream->arq->consume();
+            }
+            catch (const std::runtime_error &e)
+            {
+                throw cRuntimeError("%s", e.what());
+            }
+        }
     }
-    // Case "0011": Duplication with delay
-    else if (errorCode == "0011")
-    {
-        CustomMessage *duplicate = frame->dup();
-        sendDelayed(frame, processingTime + transmissionDelay + errorDelay, "out");
-        sendDelayed(duplicate, processingTime + transmissionDelay + errorDelay + duplicationDelay, "out");
-        state = "[sent] frame with seq_num=[" + std::to_string(seqNum) +
-                "] and payload=[" + payload +
-                "] and trailer=[" + std::bitset<8>(trailer).to_string() +
-                "] , Modified [-1], Lost [No], Duplicate [1], Delay [" + std::to_string(errorDelay) + "]";
-
-        prints.push(state);
-        scheduleAt(simTime() + processingTime, new cMessage("Print"));
-
-        std::string state2 = "[sent] frame with seq_num=[" + std::to_string(seqNum) +
-                             "] and payload=[" + payload +
-                             "] and trailer=[" + std::bitset<8>(trailer).to_string() +
-                             "] , Modified [-1], Lost [No], Duplicate [2], Delay [" + std::to_string(errorDelay) + "]";
+}
 
-        prints.push(state2);
-        scheduleAt(simTime() + processingTime + duplicationDelay, new cMessage("Print"));
-    }
-    // Case "1100": Loss with modification
-    else if (errorCode == "1100")
-    {
-        bitPosition = rand() % (payload.length() * 8);
-        char &byte = payload[bitPosition / 8];
-        byte ^= (1 << (bitPosition % 8));
-        modified = true;
-
-        state = "[sent] frame with seq_num=[" + std::to_string(seqNum) +
-                "] and payload=[" + payload +
-                "] and trailer=[" + std::bitset<8>(trailer).to_string() +
-                "] , Modified [" + std::to_string(bitPosition) +
-                "], Lost [Yes], Duplicate [1], Delay [0]";
-        prints.push(state);
-        scheduleAt(simTime() + processingTime, new cMessage("Print"));
-
-        delete frame;
-        return;
-    }
-    // Case "1101": Loss with modification and delay
-    else if (errorCode == "1101")
-    {
-        bitPosition = rand() % (payload.length() * 8);
-        char &byte = payload[bitPosition / 8];
-        byte ^= (1 << (bitPosition % 8));
-        modified = true;
-
-        state = "[sent] frame with seq_num=[" + std::to_string(seqNum) +
-                "] and payload=[" + payload +
-                "] and trailer=[" + std::bitset<8>(trailer).to_string() +
-                "] ,Modified [" + std::to_string(bitPosition) +
-                "], Lost [Yes], Duplicate [0], Delay [" + std::to_string(errorDelay) + "]";
-        prints.push(state);
-        scheduleAt(simTime() + processingTime, new cMessage("Print"));
-        delete frame;
-        return;
-    }
-    // Case "1110": Loss with modification and duplication
-    else if (errorCode == "1110")
+void Node::logDelayed(const LogRecord &record, double delay)
+{
+    if (printCount == prints.size())
     {
-        bitPosition = rand() % (payload.length() * 8);
-        char &byte = payload[bitPosition / 8];
-        byte ^= (1 << (bitPosition % 8));
-        modified = true;
-
-        state = "[sent] frame with seq_num=[" + std::to_string(seqNum) +
-                "] and payload=[" + payload +
-                "] and trailer=[" + std::bitset<8>(trailer).to_string() +
-                "] , Modified [" + std::to_string(bitPosition) +
-                "], Lost [Yes], Duplicate [1], Delay [0]";
-        prints.push(state);
-        scheduleAt(simTime() + processingTime, new cMessage("Print"));
-
-        std::string state2 = "[sent] frame with seq_num=[" + std::to_string(seqNum) +
-                             "] and payload=[" + payload +
-                             "] and trailer=[" + std::bitset<8>(trailer).to_string() +
-                             "] , Modified [" + std::to_string(bitPosition) +
-                             "], Lost [Yes], Duplicate [2], Delay [0]";
-
-        prints.push(state2);
-        scheduleAt(simTime() + processingTime + duplicationDelay, new cMessage("Print"));
-
-        delete frame;
-        return;
+        // Full: unroll the ring so the oldest record comes first, then grow
+        std::rotate(prints.begin(), prints.begin() + printHead, prints.end());
+        printHead = 0;
+        prints.resize(std::max<size_t>(8, 2 * prints.size()));
     }
-    // Case "1111": Loss with modification, duplication and delay
-    else if (errorCode == "1111")
-    {
-        bitPosition = rand() % (payload.length() * 8);
-        char &byte = payload[bitPosition / 8];
-        byte ^= (1 << (bitPosition % 8));
-        modified = true;
+    prints[(printHead + printCount++) % prints.size()] = record;
+    if (calendarTimers)
+        pushCalendar(CALENDAR_PRINT, 0, 0, delay);
+    else
+        scheduleAt(simTime() + delay, new cMessage("Print"));
+}
 
-        state = "[sent] frame with seq_num=[" + std::to_string(seqNum) +
-                "] and payload=[" + payload +
-                "] and trailer=[" + std::bitset<8>(trailer).to_string() +
-                "] , Modified [" + std::to_string(bitPosition) +
-                "], Lost [Yes], Duplicate [1], Delay [" + std::to_string(errorDelay) + "]";
-        prints.push(state);
-        scheduleAt(simTime() + processingTime, new cMessage("Print"));
+void Node::printNext()
+{
+    const LogRecord &record = prints[printHead];
+    printHead = (printHead + 1) % prints.size();
+    printCount--;
 
-        std::string state2 = "[sent] frame with seq_num=[" + std::to_string(seqNum) +
-                             "] and payload=[" + payload +
-                             "] and trailer=[" + std::bitset<8>(trailer).to_string() +
-                             "] , Modified [" + std::to_string(bitPosition) +
-                             "], Lost [Yes], Duplicate [2], Delay [" + std::to_string(errorDelay) + "]";
+    logRecord(record);
+}
 
-        prints.push(state2);
-        scheduleAt(simTime() + processingTime + duplicationDelay, new cMessage("Print"));
+void Node::logEvent(LogRecord::Kind kind, int number, std::string_view payload)
+{
+    event.kind = kind;
+    event.number = number;
+    event.payload.assign(payload);
+    logRecord(event);
+}
 
-        delete frame;
+void Node::logRecord(const LogRecord &record)
+{
+    if (binaryTrace)
+    {
+        outputTrace().write(simTime().raw(), getIndex(), record);
         return;
     }
-    // Case "1000": Modification only
-    else if (errorCode == "1000")
-    {
-        bitPosition = rand() % (payload.length() * 8);
-        char &byte = payload[bitPosition / 8];
-        byte ^= (1 << (bitPosition % 8));
-        frame->setM_Payload(payload.c_str());
-        modified = true;
-        sendDelayed(frame, processingTime + transmissionDelay, "out");
-        state = "[sent] frame with seq_num=[" + std::to_string(seqNum) +
-                "] and payload=[" + payload +
-                "] and trailer=[" + std::bitset<8>(trailer).to_string() +
-                "] , Modified [" + std::to_string(bitPosition) +
-                "], Lost [No], Duplicate [0], Delay [0]";
 
-        prints.push(state);
-        scheduleAt(simTime() + processingTime, new cMessage("Print"));
-    }
-    // Case "1001": Modification and delay
-    else if (errorCode == "1001")
-    {
-        bitPosition = rand() % (payload.length() * 8);
-        char &byte = payload[bitPosition / 8];
-        byte ^= (1 << (bitPosition % 8));
-        frame->setM_Payload(payload.c_str());
-        modified = true;
-        sendDelayed(frame, processingTime + transmissionDelay + errorDelay, "out");
+    char time[64];
+    LogSink &sink = outputLog();
+    writePrefix(sink, simTime().str(time), getIndex());
+    writeRecord(sink, record);
+    // Outside EV, which skips its operands when logging is off
+    std::string_view line = sink.endLine();
+    EV << "str: " << line << endl;
+}
 
-        state = "[sent] frame with seq_num=[" + std::to_string(seqNum) +
-                "] and payload=[" + payload +
-                "] and trailer=[" + std::bitset<8>(trailer).to_string() +
-                "] , Modified [" + std::to_string(bitPosition) +
-                "], Lost [No], Duplicate [0], Delay [" + std::to_string(errorDelay) + "]";
+void Node::finish()
+{
+    if (binaryTrace)
+        outputTrace().flush();
+    else
+        outputLog().flush();
+
+    for (auto &stream : streams)
+        recordStreamScalars(*stream);
+    recordScalar("framesAllocated", framePool.allocations());
+    recordScalar("framesReused", framePool.reuses());
+
+#ifndef NDEBUG
+    // Every frame is released by its receiver; only those still on the way
+    // or dropped by a full channel queue may be missing at the end
+    if (getIndex() == 0 && MessagePool::unreturned() > 0)
+        EV_WARN << MessagePool::unreturned() << " frames not returned to a pool (in flight or dropped by a channel)\n";
+#endif
+}
 
-        prints.push(state);
-        scheduleAt(simTime() + processingTime, new cMessage("Print"));
+void Node::recordStreamScalars(const Stream &stream)
+{
+    // A single stream keeps the plain names
+    std::string prefix = streams.size() > 1 ? "stream" + std::to_string(stream.id) + "." : "";
+    auto record = [&](const char *name, double value) { recordScalar((prefix + name).c_str(), value); };
+
+    const ArqConfig &config = stream.arq->configuration();
+    const ArqStats &stats = stream.arq->stats();
+    record("retransmissions", stats.retransmissions);
+    if (stream.arq->hasRtt())
+    {
+        record("srtt", stream.arq->smoothedRtt());
+        record("rttvar", stream.arq->rttVariation());
     }
-    // Case "1010": Modification and duplication
-    else if (errorCode == "1010")
+    record("finalRto", stream.arq->currentRto());
+    record("sackRetransmissions", stats.sackRetransmissions);
+    if (config.aggregation && stats.aggregateFrames > 0)
+        record("messagesPerFrame", (double)stats.aggregatedMessages / stats.aggregateFrames);
+    if (config.fragmentation)
     {
-        bitPosition = rand() % (payload.length() * 8);
-        char &byte = payload[bitPosition / 8];
-        byte ^= (1 << (bitPosition % 8));
-        frame->setM_Payload(payload.c_str());
-        modified = true;
-        CustomMessage *duplicate = frame->dup();
-        sendDelayed(frame, processingTime + transmissionDelay, "out");
-        sendDelayed(duplicate, processingTime + transmissionDelay + duplicationDelay, "out");
-
-        state = "[sent] frame with seq_num=[" + std::to_string(seqNum) +
-                "] and payload=[" + payload +
-                "] and trailer=[" + std::bitset<8>(trailer).to_string() +
-                "] , Modified [" + std::to_string(bitPosition) +
-                "], Lost [No], Duplicate [1], Delay [0]";
-
-        prints.push(state);
-        scheduleAt(simTime() + processingTime, new cMessage("Print"));
-
-        std::string state2 = "[sent] frame with seq_num=[" + std::to_string(seqNum) +
-                             "] and payload=[" + payload +
-                             "] and trailer=[" + std::bitset<8>(trailer).to_string() +
-                             "] , Modified [" + std::to_string(bitPosition) +
-                             "], Lost [No], Duplicate [2], Delay [0]";
-
-        prints.push(state2);
-        scheduleAt(simTime() + processingTime + duplicationDelay, new cMessage("Print"));
+        record("fragmentsSent", stats.fragmentsSent);
+        record("reassembledMessages", stats.reassembledMessages);
+        record("droppedFragments", stats.droppedFragments);
     }
-    // Case "1011": Modification, duplication and delay
-    else if (errorCode == "1011")
+    record("reusedFrames", stats.reusedFrames);
+    record("framingPayloadBytes", stats.framingPayloadBytes);
+    record("framingLineBits", stats.framingLineBits);
+    if (stats.framingPayloadBytes > 0)
+        record("framingOverhead", (double)stats.framingLineBits / (8 * stats.framingPayloadBytes) - 1);
+    record("framingCpuTime", stats.framingTime);
+    if (config.compression)
     {
-        bitPosition = rand() % (payload.length() * 8);
-        char &byte = payload[bitPosition / 8];
-        byte ^= (1 << (bitPosition % 8));
-        frame->setM_Payload(payload.c_str());
-        modified = true;
-        CustomMessage *duplicate = frame->dup();
-        sendDelayed(frame, processingTime + transmissionDelay + errorDelay, "out");
-        sendDelayed(duplicate, processingTime + transmissionDelay + errorDelay + duplicationDelay, "out");
-
-        state = "[sent] frame with seq_num=[" + std::to_string(seqNum) +
-                "] and payload=[" + payload +
-                "] and trailer=[" + std::bitset<8>(trailer).to_string() +
-                "] , Modified [" + std::to_string(bitPosition) +
-                "], Lost [No], Duplicate [1], Delay [" + std::to_string(errorDelay) + "]";
-
-        prints.push(state);
-        scheduleAt(simTime() + processingTime, new cMessage("Print"));
-
-        std::string state2 = "[sent] frame with seq_num=[" + std::to_string(seqNum) +
-                             "] and payload=[" + payload +
-                             "] and trailer=[" + std::bitset<8>(trailer).to_string() +
-                             "] , Modified [" + std::to_string(bitPosition) +
-                             "], Lost [No], Duplicate [2], Delay [" + std::to_string(errorDelay) + "]";
-
-        prints.push(state2);
-
-        scheduleAt(simTime() + processingTime + duplicationDelay, new cMessage("Print"));
+        record("compressionBytesIn", stats.compressionBytesIn);
+        record("compressionBytesOut", stats.compressionBytesOut);
+        if (stats.compressionBytesOut > 0)
+            record("compressionRatio", (double)stats.compressionBytesIn / stats.compressionBytesOut);
+        record("compressCpuTime", stats.compressTime);
+        record("decompressCpuTime", stats.decompressTime);
     }
-}
-char Node::calculateParity(const std::string &payload)
-{
-    char parity = 0;
-    for (char c : payload)
+    if (config.fecMode != FEC_NONE)
     {
-        parity ^= c; // XOR all the characters to calculate parity
+        record("fecCorrections", stats.fecCorrections);
+        record("fecRepairedFrames", stats.fecRepairedFrames);
+        record("fecFailures", stats.fecFailures);
+        record("fecOverheadBytes", stats.fecOverheadBytes);
     }
-    return parity;
-}
-
-void Node::logEvent(const std::string &event, int i)
-{
-    std::ofstream logFile("output.txt", std::ios::app);
-    if (!logFile.is_open())
+    record("standaloneAcks", stats.standaloneAcks);
+    record("piggybackedAcks", stats.piggybackedAcks);
+    record("framesDelivered", stats.framesDelivered);
+    if (stats.framesDelivered > 0)
+        record("acksPerDeliveredFrame", (double)(stats.standaloneAcks + stats.piggybackedAcks) / stats.framesDelivered);
+    if (config.deliveryQueue > 0)
     {
-        EV << "Error opening log file!\n";
-        return;
+        record("creditStalls", stats.creditStalls);
+        record("windowUpdates", stats.windowUpdates);
     }
-
-    logFile << "At time [" << simTime() + i << "], Node[" << getIndex()
-            << "]: " << event << "\n";
-
-
-
-    logFile.close();
 }
@@ -17,65 +17,137 @@
 #define __DATALINKLAYERNETWORK_NODE_H_
 
 #include <omnetpp.h>
-#include <fstream> // For file input/output
-#include <queue>
+#include <memory>
+#include <string_view>
+#include "Arq.h"
+#include "CalendarQueue.h"
+#include "LogFormat.h"
+#include "MessagePool.h"
+#include "Trace.h"
 
 using namespace omnetpp;
 
 /**
- * TODO - Generated class
+ * Data link layer node. The protocol itself lives in ArqEndpoint (Arq.h);
+ * Node supplies it with simulation time and timers, carries its frames as
+ * CustomMessages and writes its log records.
+ *
+ * With streams > 1 the link carries that many logical channels, each an
+ * ArqEndpoint with its own window, sequence space and timers; frames name
+ * theirs in M_Stream. New data frames share the link: one leaves every
+ * processingTime, from the stream the streamScheduler picks, so a short
+ * message on a high-priority stream does not wait behind a bulk stream's
+ * window. Retransmissions and ACKs go out as soon as they are due.
  */
 class Node : public cSimpleModule
 {
 private:
-    std::vector<std::string> messages;
-    int seqNum = 0;         // Current sequence number
-    int windowSize;         // Sliding window size
-    double timeoutInterval; // Timeout interval in seconds
-    double processingTime;
-    double transmissionDelay;
-    double errorDelay;
-    double duplicationDelay;
-    double lossProb;
-    int maxSeqNumber;      // Maximum sequence number
-    std::ofstream logFile; // Log file
-
-    std::queue<std::string> prints;
-
-    std::vector<std::string> senderWindow;   // Buffer for sender window
-    std::vector<bool> frameReceived;         // Track received frames
-    std::vector<std::string> receiverBuffer; // Buffer for receiver window
-    std::vector<bool> ackReceived;           // Track received ACKs
-    std::vector<cMessage *> timers;          // Timers for frames
-    int nextFrameToSend;                     // Next frame to send
-    int expectedFrameToReceive;              // Expected frame at receiver
-    int totalFramesAccepted;                 // Counter for accepted frames
-    int currentIndex;                        // Current index in sender window
-    int baseIndex;                           // Base index for sender window
-    simtime_t lastFrameTime;                 // Time of last accepted frame
-
-    // Constants
-    static const int FRAME_DATA = 2;
-    static const int FRAME_ACK = 1;
-    static const int FRAME_NACK = 0;
-
-    void sendFrames();
-    void handleAck(cMessage *msg);
-    void receiveFrame(cMessage *msg);
-    void readFile(const char *filename);
-    // Error simulation and utilities
-    std::string byteStuff(const std::string &payload);
-    std::string byteUnstuff(const std::string &framed);
-    char computeCRC(const std::string &data);
-    bool checkCRC(const std::string &data, char crc);
-    void simulateErrors(CustomMessage *frame, const std::string &errorCode, int i);
-    void logEvent(const std::string &event, int i = 0);
-    char calculateParity(const std::string &payload);
-    void handleTimeout(int seqNum);
+    // A timer, SendNextFrame or Print waiting in the calendar queue
+    struct CalendarTimer
+    {
+        int64_t at = -1;                     // Raw simulation time, -1 for a stopped timer
+        uint64_t order = 0;
+        int kind = 0;                        // An ArqTimer, CALENDAR_SEND or CALENDAR_PRINT
+        int stream = 0;
+        int index = 0;
+    };
+    enum { CALENDAR_SEND = TIMER_REASSEMBLY + 1, CALENDAR_PRINT };
+
+    // One logical channel: the clock and transport of its ArqEndpoint,
+    // which hand its calls to the node along with the stream
+    class Stream : public ArqClock, public ArqTransport
+    {
+    public:
+        Node &node;
+        int id;
+        std::unique_ptr<ArqEndpoint> arq;
+        std::vector<cMessage *> timers;      // Retransmission timers, one per window slot
+        cMessage *ackTimer = nullptr;        // Delayed-ACK timer
+        cMessage *reassemblyTimer = nullptr;
+        std::vector<CalendarTimer> runningTimers; // By timer slot, see timerSlot()
+        cOutVector rttVector;
+        cOutVector rtoVector;
+
+        // Link scheduler (streams > 1)
+        bool wantsSend = false;              // Asked for a send slot
+        double weight = 1;                   // "wfq": share of the send slots
+        double finishTag = 0;                // "wfq": virtual time its last frame finished
+
+        Stream(Node &node, int id) : node(node), id(id) {}
+
+        // ArqClock
+        virtual ArqTime now() const override;
+        virtual ArqTime fromSeconds(double seconds) const override;
+        virtual double toSeconds(ArqTime time) const override;
+        virtual void startTimer(ArqTimer timer, int index, double delay) override;
+        virtual void cancelTimer(ArqTimer timer, int index) override;
+        virtual void scheduleSend(double delay) override;
+
+        // ArqTransport
+        virtual void transmit(const ArqFrame &frame, double delay) override;
+        virtual void deliver(std::string_view message, int seqNum) override;
+        virtual void log(const LogRecord &record) override;
+        virtual void logDelayed(const LogRecord &record, double delay) override;
+        virtual void note(const char *text) override;
+        virtual void rttSample(double rtt) override;
+        virtual void rtoChanged(double rto) override;
+    };
+
+    std::vector<std::unique_ptr<Stream>> streams;
+    MessagePool framePool;                   // Received frames, reused by transmit()
+
+    // streams > 1: the next data frame's slot on the link
+    bool fairScheduler;                      // streamScheduler = "wfq", else strict priority
+    double processingTime;                   // Time between send slots
+    cMessage *sendSlot;
+    double virtualTime = 0;                  // "wfq": start tag of the frame last given a slot
+
+    // timerQueue = "calendar": the node's timed events wait in its own
+    // calendar queue and a single self-message wakes it for the earliest
+    bool calendarTimers;
+    CalendarQueue<CalendarTimer> calendar;
+    cMessage *calendarWakeup;
+    uint64_t calendarOrder = 0;
+    bool inCalendar = false;                 // runCalendar() is dispatching
+
+    bool hasUpperLayer;                      // Delivered messages go up to a NetworkLayer
+    int upperCredit = 1;                     // Messages the NetworkLayer takes now (deliveryQueue > 0)
+    bool binaryTrace;                        // Log to output.trace instead of output.txt
+    LogRecord event;                         // Scratch record for lines logged right away
+
+    // Lines waiting for their "Print" event, a ring with the oldest at printHead
+    std::vector<LogRecord> prints;
+    size_t printHead = 0;
+    size_t printCount = 0;
+
+    void readFile(const char *filename, std::vector<std::string> &lines);
+    void logEvent(LogRecord::Kind kind, int number, std::string_view payload = {});
+    void logRecord(const LogRecord &record);
+    void logDelayed(const LogRecord &record, double delay);
+    void printNext();
+    void drainDeliveries();
+    Stream &streamOf(int index);
+    cMessage *&timerMessage(Stream &stream, ArqTimer timer, int index);
+    size_t timerSlot(const Stream &stream, ArqTimer timer, int index) const;
+    void startTimer(Stream &stream, ArqTimer timer, int index, double delay);
+    void cancelTimer(Stream &stream, ArqTimer timer, int index);
+    void scheduleSend(Stream &stream, double delay);
+    void sendNext();
+    CalendarTimer pushCalendar(int kind, int stream, int index, double delay);
+    void runCalendar();
+    void rescheduleWakeup();
+    void transmit(Stream &stream, const ArqFrame &frame, double delay);
+    void deliver(Stream &stream, std::string_view message, int seqNum);
+    void recordStreamScalars(const Stream &stream);
 
 protected:
     virtual void initialize() override;
     virtual void handleMessage(cMessage *msg) override;
+    virtual void finish() override;
+
+public:
+    Node() : sendSlot(nullptr), calendarWakeup(nullptr) {}
+    virtual ~Node();
 };
 
 #endif
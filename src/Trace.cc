@@ -0,0 +1,175 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+#include "Trace.h"
+#include <cstring>
+
+TraceWriter::TraceWriter(const std::string &path, int scaleExp)
+    : records(std::fopen(path.c_str(), "a+b")), payloads(std::fopen((path + ".payload").c_str(), "ab")),
+      recordBuffer(new TraceRecord[RECORD_BUFFER]), recordCount(0), payloadBytes(0), lastOffset(0)
+{
+    payloadBuffer.reserve(2 * PAYLOAD_BUFFER);
+    if (!isOpen())
+    {
+        close();
+        return;
+    }
+    std::setvbuf(records, nullptr, _IONBF, 0);
+    std::setvbuf(payloads, nullptr, _IONBF, 0);
+
+    TraceHeader header = {};
+    std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.recordSize = sizeof(TraceRecord);
+    header.scaleExp = scaleExp;
+
+    std::fseek(records, 0, SEEK_END);
+    if (std::ftell(records) == 0)
+    {
+        std::fwrite(&header, sizeof(header), 1, records);
+    }
+    else
+    {
+        // Records of an earlier run: later ones must share their format and
+        // time unit, or the trace could not be read back as one
+        TraceHeader existing;
+        std::rewind(records);
+        if (std::fread(&existing, sizeof(existing), 1, records) != 1 ||
+            std::memcmp(&existing, &header, sizeof(header)) != 0)
+        {
+            close();
+            return;
+        }
+    }
+
+    // Offsets continue after the payloads already in the file
+    std::fseek(payloads, 0, SEEK_END);
+    payloadBytes = std::ftell(payloads);
+}
+
+void TraceWriter::close()
+{
+    if (records)
+        std::fclose(records);
+    if (payloads)
+        std::fclose(payloads);
+    records = nullptr;
+    payloads = nullptr;
+}
+
+TraceWriter::~TraceWriter()
+{
+    flush();
+    close();
+}
+
+void TraceWriter::flush()
+{
+    if (records && recordCount > 0)
+        std::fwrite(recordBuffer.get(), sizeof(TraceRecord), recordCount, records);
+    if (payloads && !payloadBuffer.empty())
+        std::fwrite(payloadBuffer.data(), 1, payloadBuffer.size(), payloads);
+    recordCount = 0;
+    payloadBuffer.clear();
+}
+
+void TraceWriter::write(int64_t time, int node, const LogRecord &record)
+{
+    if (recordCount == RECORD_BUFFER || payloadBuffer.size() >= PAYLOAD_BUFFER)
+        flush();
+
+    TraceRecord &trace = recordBuffer[recordCount++];
+    std::memset(&trace, 0, sizeof(trace));
+    trace.time = time;
+    trace.node = (uint16_t)node;
+    trace.type = (uint8_t)record.kind;
+    trace.number = record.number;
+    trace.bitPosition = -1;
+
+    if (!record.payload.empty())
+    {
+        if (record.payload != lastPayload)
+        {
+            lastOffset = payloadBytes;
+            payloadBuffer.append(record.payload);
+            payloadBytes += record.payload.size();
+            lastPayload.assign(record.payload);
+        }
+        trace.payloadOffset = lastOffset;
+        trace.payloadLength = (uint32_t)record.payload.size();
+    }
+
+    if (record.kind == LogRecord::SENT)
+    {
+        trace.delay = record.delay;
+        trace.bitPosition = record.modifiedBit;
+        trace.flags = (record.lost ? TRACE_LOST : 0) | (record.delayed ? TRACE_DELAYED : 0);
+        trace.trailer = (uint8_t)record.trailer;
+        trace.duplicate = (uint8_t)record.duplicate;
+    }
+}
+
+void traceToLog(const TraceRecord &trace, std::string_view payload, LogRecord &record)
+{
+    record.kind = (LogRecord::Kind)trace.type;
+    record.number = trace.number;
+    record.payload.assign(payload);
+    record.trailer = (char)trace.trailer;
+    record.modifiedBit = trace.bitPosition;
+    record.lost = trace.flags & TRACE_LOST;
+    record.duplicate = trace.duplicate;
+    record.delayed = trace.flags & TRACE_DELAYED;
+    record.delay = trace.delay;
+}
+
+const char *formatTraceTime(char *buf, int64_t time, int scaleExp)
+{
+    // Digits are produced backwards from the end of buf
+    char *end = buf + 63;
+    char *s = end;
+    *s = '\0';
+    if (time == 0)
+    {
+        *--s = '0';
+        return s;
+    }
+
+    bool negative = time < 0;
+    uint64_t t = negative ? -(uint64_t)time : (uint64_t)time;
+    bool skipZeros = true;
+    int decimalPlace = scaleExp;
+    do
+    {
+        int digit = (int)(t % 10);
+        if (skipZeros && (digit != 0 || decimalPlace >= 0))
+            skipZeros = false;
+        if (decimalPlace++ == 0 && s != end)
+            *--s = '.';
+        if (!skipZeros)
+            *--s = (char)('0' + digit);
+        t /= 10;
+    } while (t);
+
+    // Leading zeros of a time below one second
+    if (decimalPlace <= 0)
+    {
+        while (decimalPlace++ < 0)
+            *--s = '0';
+        *--s = '.';
+        *--s = '0';
+    }
+    if (negative)
+        *--s = '-';
+    return s;
+}
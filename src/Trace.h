@@ -0,0 +1,118 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __DATALINKLAYERNETWORK_TRACE_H_
+#define __DATALINKLAYERNETWORK_TRACE_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "LogFormat.h"
+
+/**
+ * Binary event trace, the compact alternative to output.txt. A trace is two
+ * files: "<name>" holds a TraceHeader followed by fixed-size TraceRecords,
+ * and "<name>.payload" holds the payload bytes the records refer to by
+ * offset and length. Records can therefore be indexed and skipped without
+ * parsing, and a payload logged twice in a row (a frame and its duplicate)
+ * is stored once. Both files are in host byte order.
+ *
+ * Like output.txt (LogSink), a trace is appended to: each run adds its
+ * records after those of the runs before, so output.trace and output.txt
+ * cover the same runs and trace2text reproduces the whole text log. A run
+ * whose header differs from the file's, e.g. with another simulation time
+ * unit, cannot append; delete the trace first.
+ *
+ * tools/trace2text renders a trace as the exact output.txt text.
+ */
+const char TRACE_MAGIC[8] = {'D', 'L', 'L', 'T', 'R', 'A', 'C', 'E'};
+const uint32_t TRACE_VERSION = 1;
+
+struct TraceHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;     // sizeof(TraceRecord)
+    int32_t scaleExp;        // Simulation time unit is 10^scaleExp seconds
+    uint32_t reserved;
+};
+
+enum TraceFlags : uint8_t
+{
+    TRACE_LOST = 0x01,
+    TRACE_DELAYED = 0x02
+};
+
+struct TraceRecord
+{
+    int64_t time;            // Simulation time in units of 10^scaleExp s
+    double delay;            // Delay of a delayed frame
+    uint64_t payloadOffset;  // Into the payload file
+    uint32_t payloadLength;
+    int32_t number;          // seq_num, ACK/NACK number or frame slot
+    int32_t bitPosition;     // Modified bit of a sent frame, -1 if intact
+    uint16_t node;
+    uint8_t type;            // LogRecord::Kind
+    uint8_t flags;           // TraceFlags
+    uint8_t trailer;
+    uint8_t duplicate;
+    uint8_t reserved[6];
+};
+
+static_assert(sizeof(TraceHeader) == 24, "TraceHeader layout");
+static_assert(sizeof(TraceRecord) == 48, "TraceRecord layout");
+
+/**
+ * Buffered trace writer. Records and payload bytes are collected in memory
+ * and reach their files in large writes. Like LogSink, one writer is shared
+ * by all nodes so records keep their global event order.
+ */
+class TraceWriter
+{
+public:
+    TraceWriter(const std::string &path, int scaleExp);
+    ~TraceWriter();
+
+    // False if a file could not be opened, or the trace on disk has another header
+    bool isOpen() const { return records != nullptr && payloads != nullptr; }
+    void write(int64_t time, int node, const LogRecord &record);
+    void flush();
+
+private:
+    static const size_t RECORD_BUFFER = 1024;
+    static const size_t PAYLOAD_BUFFER = 64 * 1024;
+
+    void close();
+
+    FILE *records;
+    FILE *payloads;
+    std::unique_ptr<TraceRecord[]> recordBuffer;
+    size_t recordCount;
+    std::string payloadBuffer;
+    uint64_t payloadBytes;                   // Payload bytes written so far, flushed or not
+    std::string lastPayload;                 // Most recent payload, for de-duplication
+    uint64_t lastOffset;
+};
+
+// Unpacks a record; payload is the referenced bytes of the payload file
+void traceToLog(const TraceRecord &trace, std::string_view payload, LogRecord &record);
+
+// Prints a simulation time the way SimTime::str() does: seconds, without
+// trailing zeros. buf needs 64 bytes; returns the start of the text in buf.
+const char *formatTraceTime(char *buf, int64_t time, int scaleExp);
+
+#endif
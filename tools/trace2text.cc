@@ -0,0 +1,131 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+//
+// Renders a binary event trace (output.trace, see src/Trace.h) as the
+// output.txt text the simulation writes with traceFormat="text".
+//
+//   trace2text output.trace [output.txt]
+//
+// The text goes to stdout unless an output file is given, which is appended
+// to like the simulation's own output.txt. Both trace files are mapped into
+// memory, so records are read in place.
+//
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include "LogFormat.h"
+#include "Trace.h"
+
+namespace {
+
+struct MappedFile
+{
+    const char *data = nullptr;
+    size_t size = 0;
+
+    bool open(const std::string &path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        bool ok = fstat(fd, &st) == 0;
+        size = ok ? (size_t)st.st_size : 0;
+        if (ok && size > 0)
+        {
+            void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ok = p != MAP_FAILED;
+            if (ok)
+            {
+                data = (const char *)p;
+                madvise(p, size, MADV_SEQUENTIAL);
+            }
+        }
+        close(fd);
+        return ok;
+    }
+
+    ~MappedFile()
+    {
+        if (data)
+            munmap((void *)data, size);
+    }
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::fprintf(stderr, "usage: %s output.trace [output.txt]\n", argv[0]);
+        return 2;
+    }
+
+    std::string path = argv[1];
+    MappedFile records, payloads;
+    if (!records.open(path) || !payloads.open(path + ".payload"))
+    {
+        std::fprintf(stderr, "%s: cannot read %s and %s.payload\n", argv[0], path.c_str(), path.c_str());
+        return 1;
+    }
+
+    TraceHeader header;
+    if (records.size < sizeof(header))
+    {
+        std::fprintf(stderr, "%s: %s is not a trace\n", argv[0], path.c_str());
+        return 1;
+    }
+    std::memcpy(&header, records.data, sizeof(header));
+    if (std::memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != TRACE_VERSION || header.recordSize != sizeof(TraceRecord))
+    {
+        std::fprintf(stderr, "%s: %s is not a version %u trace\n", argv[0], path.c_str(), TRACE_VERSION);
+        return 1;
+    }
+
+    LogSink sink(argc == 3 ? argv[2] : "/dev/stdout");
+    if (!sink.isOpen())
+    {
+        std::fprintf(stderr, "%s: cannot open %s\n", argv[0], argc == 3 ? argv[2] : "stdout");
+        return 1;
+    }
+
+    size_t count = (records.size - sizeof(header)) / sizeof(TraceRecord);
+    const char *next = records.data + sizeof(header);
+    LogRecord record;
+    char time[64];
+    for (size_t i = 0; i < count; i++, next += sizeof(TraceRecord))
+    {
+        TraceRecord trace;
+        std::memcpy(&trace, next, sizeof(trace));
+        if (trace.payloadOffset + trace.payloadLength > payloads.size)
+        {
+            std::fprintf(stderr, "%s: record %zu refers past the end of the payload file\n", argv[0], i);
+            return 1;
+        }
+
+        traceToLog(trace, std::string_view(payloads.data + trace.payloadOffset, trace.payloadLength), record);
+        writePrefix(sink, formatTraceTime(time, trace.time, header.scaleExp), trace.node);
+        writeRecord(sink, record);
+        sink.endLine();
+    }
+    return 0;
+}
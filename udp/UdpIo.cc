@@ -0,0 +1,653 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "UdpIo.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <linux/errqueue.h>
+#include <linux/io_uring.h>
+#include <linux/net_tstamp.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const int BATCH = 64;                 // Datagrams per sendmmsg()/recvmmsg() call
+const size_t MAX_DATAGRAM = 65536;
+
+timespec toTimespec(ArqTime ns)
+{
+    return timespec{(time_t)(ns / 1000000000), (long)(ns % 1000000000)};
+}
+
+// The SO_TIMESTAMPING software receive time among a message's control data
+bool kernelTimestamp(msghdr &header, ArqTime &time)
+{
+    for (cmsghdr *c = CMSG_FIRSTHDR(&header); c; c = CMSG_NXTHDR(&header, c))
+    {
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPING)
+        {
+            scm_timestamping stamps;
+            std::memcpy(&stamps, CMSG_DATA(c), sizeof(stamps));
+            if (stamps.ts[0].tv_sec != 0 || stamps.ts[0].tv_nsec != 0)
+            {
+                time = (ArqTime)stamps.ts[0].tv_sec * 1000000000 + stamps.ts[0].tv_nsec;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+//
+// The plain system call path: one sendmmsg() per batch of due datagrams,
+// recvmmsg() until the socket is empty, a write() per log block.
+//
+class EpollEngine : public IoEngine
+{
+public:
+    EpollEngine(int fd, int logFd, int epoll);
+    virtual ~EpollEngine() { close(epoll); }
+
+    virtual const char *name() const override { return "epoll"; }
+    virtual void send(const char *data, size_t length) override;
+    virtual void writeLog(const char *data, size_t length) override;
+    virtual void wait(ArqTime timeout, DatagramHandler &handler) override;
+    virtual void drain() override { flushSends(); }
+
+private:
+    int fd;
+    int logFd;
+    int epoll;
+    std::vector<iovec> queued;
+    std::vector<char> buffers;        // BATCH receive buffers, each with room for a NUL
+
+    void flushSends();
+    void receiveBatch(DatagramHandler &handler);
+};
+
+EpollEngine::EpollEngine(int fd, int logFd, int epoll)
+    : fd(fd), logFd(logFd), epoll(epoll), buffers(BATCH * (MAX_DATAGRAM + 1))
+{
+}
+
+void EpollEngine::send(const char *data, size_t length)
+{
+    queued.push_back(iovec{(void *)data, length});
+}
+
+void EpollEngine::writeLog(const char *data, size_t length)
+{
+    counters.logWrites++;
+    while (length > 0)
+    {
+        ssize_t written = ::write(logFd, data, length);
+        counters.syscalls++;
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        data += written;
+        length -= written;
+    }
+}
+
+void EpollEngine::flushSends()
+{
+    mmsghdr messages[BATCH];
+    size_t done = 0;
+    while (done < queued.size())
+    {
+        int count = (int)std::min<size_t>(BATCH, queued.size() - done);
+        for (int i = 0; i < count; i++)
+        {
+            std::memset(&messages[i], 0, sizeof(messages[i]));
+            messages[i].msg_hdr.msg_iov = &queued[done + i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+        int sent = sendmmsg(fd, messages, count, 0);
+        counters.syscalls++;
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            // A full socket buffer or an unreachable peer is a lost frame to the protocol
+            sent = 1;
+        }
+        else
+        {
+            counters.datagramsSent += sent;
+        }
+        done += sent;
+    }
+    queued.clear();
+}
+
+void EpollEngine::wait(ArqTime timeout, DatagramHandler &handler)
+{
+    flushSends();
+    epoll_event event;
+    timespec ts = toTimespec(timeout);
+    int ready = epoll_pwait2(epoll, &event, 1, &ts, nullptr);
+    counters.syscalls++;
+    if (ready > 0)
+        receiveBatch(handler);
+}
+
+void EpollEngine::receiveBatch(DatagramHandler &handler)
+{
+    char controls[BATCH][256];
+    mmsghdr messages[BATCH];
+    iovec iov[BATCH];
+
+    for (;;)
+    {
+        for (int i = 0; i < BATCH; i++)
+        {
+            iov[i].iov_base = &buffers[i * (MAX_DATAGRAM + 1)];
+            iov[i].iov_len = MAX_DATAGRAM;
+            std::memset(&messages[i], 0, sizeof(messages[i]));
+            messages[i].msg_hdr.msg_iov = &iov[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+            messages[i].msg_hdr.msg_control = controls[i];
+            messages[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+        }
+        int count = recvmmsg(fd, messages, BATCH, MSG_DONTWAIT, nullptr);
+        counters.syscalls++;
+        if (count <= 0)
+            return;
+        counters.datagramsReceived += count;
+
+        ArqTime arrival = wallClock();
+        for (int i = 0; i < count; i++)
+        {
+            ArqTime time = arrival;
+            bool stamped = kernelTimestamp(messages[i].msg_hdr, time);
+            handler.datagram((char *)iov[i].iov_base, messages[i].msg_len, time, stamped);
+        }
+        if (count < BATCH)
+            return;
+    }
+}
+
+//
+// io_uring without liburing. Sends come from registered send slots and
+// leave with the next io_uring_enter(), which also waits for arrivals, so
+// a loop iteration costs one system call. One multishot recvmsg stays
+// armed and fills buffers from a provided buffer ring. Log blocks are
+// copied into registered buffers and written with WRITE_FIXED at explicit
+// offsets, so they need no ordering against each other or the sends; a
+// short or failed write is finished with pwrite() when it completes.
+//
+const unsigned SQ_ENTRIES = 256;
+const unsigned CQ_ENTRIES = 4096;
+const unsigned SEND_SLOTS = 512;
+const size_t SEND_SLOT_BYTES = 2048;  // Larger datagrams are sent with send()
+const unsigned LOG_BUFFERS = 4;
+const size_t LOG_BUFFER_BYTES = 128 * 1024;
+const unsigned RECV_BUFFERS = 512;    // A power of two, as the buffer ring requires
+const size_t RECV_BUFFER_BYTES = 2048;
+const size_t CONTROL_BYTES = 128;
+const uint16_t BUFFER_GROUP = 0;
+
+// user_data: the operation in the upper half, a slot or buffer index in the lower
+enum Operation : uint64_t
+{
+    OP_RECEIVE = 1,
+    OP_SEND = 2,
+    OP_LOG = 3
+};
+
+int uringSetup(unsigned entries, io_uring_params *params)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+int uringEnter(int ring, unsigned toSubmit, unsigned minComplete, unsigned flags, void *arg, size_t argSize)
+{
+    return (int)syscall(__NR_io_uring_enter, ring, toSubmit, minComplete, flags, arg, argSize);
+}
+
+int uringRegister(int ring, unsigned opcode, void *arg, unsigned count)
+{
+    return (int)syscall(__NR_io_uring_register, ring, opcode, arg, count);
+}
+
+class UringEngine : public IoEngine
+{
+public:
+    UringEngine(int fd, int logFd) : fd(fd), logFd(logFd) {}
+    virtual ~UringEngine();
+
+    bool setup();
+
+    virtual const char *name() const override { return "uring"; }
+    virtual void send(const char *data, size_t length) override;
+    virtual void writeLog(const char *data, size_t length) override;
+    virtual void wait(ArqTime timeout, DatagramHandler &handler) override;
+    virtual void drain() override;
+
+private:
+    int fd;
+    int logFd;
+    int ring = -1;
+
+    void *ringMemory = MAP_FAILED;
+    size_t ringBytes = 0;
+    io_uring_sqe *sqes = (io_uring_sqe *)MAP_FAILED;
+    size_t sqeBytes = 0;
+    unsigned *sqHead, *sqTail, *sqMask, *sqArray;
+    unsigned sqEntries;
+    unsigned *cqHead, *cqTail, *cqMask;
+    io_uring_cqe *cqes;
+
+    char *buffers = (char *)MAP_FAILED; // Registered: send slots, then log buffers
+    char *receiveMemory = (char *)MAP_FAILED;
+    io_uring_buf_ring *bufferRing;
+    io_uring_buf *bufferEntries;
+    char *receiveBuffers;
+    msghdr receiveHeader = {};
+    bool receiving = false;
+    bool fixedSends = true;
+
+    std::vector<int> freeSendSlots;
+    std::vector<size_t> sendLengths;
+    std::vector<int> freeLogBuffers;
+    std::vector<size_t> logLengths;
+    std::vector<off_t> logOffsets;
+    off_t logEnd = 0;
+    unsigned inFlight = 0;            // Sends and log writes without a completion yet
+
+    char *sendSlot(int slot) { return buffers + slot * SEND_SLOT_BYTES; }
+    char *logBuffer(int index) { return buffers + SEND_SLOTS * SEND_SLOT_BYTES + index * LOG_BUFFER_BYTES; }
+
+    io_uring_sqe *nextSqe();
+    void publish();
+    void enter(unsigned minComplete, ArqTime timeout);
+    void reap(DatagramHandler *handler);
+    void armReceive();
+    void recycle(unsigned bid);
+    void queueSend(int slot);
+    void writeSynchronously(const char *data, size_t length, off_t offset);
+};
+
+UringEngine::~UringEngine()
+{
+    if (ring >= 0)
+        close(ring);
+    if (ringMemory != MAP_FAILED)
+        munmap(ringMemory, ringBytes);
+    if (sqes != MAP_FAILED)
+        munmap(sqes, sqeBytes);
+    if (buffers != MAP_FAILED)
+        munmap(buffers, SEND_SLOTS * SEND_SLOT_BYTES + LOG_BUFFERS * LOG_BUFFER_BYTES);
+    if (receiveMemory != MAP_FAILED)
+        munmap(receiveMemory, RECV_BUFFERS * (sizeof(io_uring_buf) + RECV_BUFFER_BYTES));
+}
+
+bool UringEngine::setup()
+{
+    // Completions are only run when this thread waits for them (6.1 and later)
+    io_uring_params params = {};
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+    params.cq_entries = CQ_ENTRIES;
+    ring = uringSetup(SQ_ENTRIES, &params);
+    if (ring < 0 && errno == EINVAL)
+    {
+        params = io_uring_params();
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = CQ_ENTRIES;
+        ring = uringSetup(SQ_ENTRIES, &params);
+    }
+    if (ring < 0)
+        return false;
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG))
+        return false;
+
+    ringBytes = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                         params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    ringMemory = mmap(nullptr, ringBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+    sqeBytes = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = (io_uring_sqe *)mmap(nullptr, sqeBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+    if (ringMemory == MAP_FAILED || sqes == MAP_FAILED)
+        return false;
+    char *base = (char *)ringMemory;
+    sqHead = (unsigned *)(base + params.sq_off.head);
+    sqTail = (unsigned *)(base + params.sq_off.tail);
+    sqMask = (unsigned *)(base + params.sq_off.ring_mask);
+    sqArray = (unsigned *)(base + params.sq_off.array);
+    sqEntries = params.sq_entries;
+    cqHead = (unsigned *)(base + params.cq_off.head);
+    cqTail = (unsigned *)(base + params.cq_off.tail);
+    cqMask = (unsigned *)(base + params.cq_off.ring_mask);
+    cqes = (io_uring_cqe *)(base + params.cq_off.cqes);
+
+    // Registered buffers: buffer index 0 holds the send slots, 1 the log buffers
+    size_t sendBytes = SEND_SLOTS * SEND_SLOT_BYTES;
+    buffers = (char *)mmap(nullptr, sendBytes + LOG_BUFFERS * LOG_BUFFER_BYTES, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (buffers == MAP_FAILED)
+        return false;
+    iovec regions[2] = {{buffers, sendBytes}, {buffers + sendBytes, LOG_BUFFERS * LOG_BUFFER_BYTES}};
+    if (uringRegister(ring, IORING_REGISTER_BUFFERS, regions, 2) != 0)
+        return false;
+
+    // Provided buffer ring for the multishot receive (5.19 and later)
+    receiveMemory = (char *)mmap(nullptr, RECV_BUFFERS * (sizeof(io_uring_buf) + RECV_BUFFER_BYTES),
+                                 PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (receiveMemory == MAP_FAILED)
+        return false;
+    // Not bufferRing->bufs: in C++ the header's flex array lands at offset 8
+    bufferRing = (io_uring_buf_ring *)receiveMemory;
+    bufferEntries = (io_uring_buf *)receiveMemory;
+    receiveBuffers = receiveMemory + RECV_BUFFERS * sizeof(io_uring_buf);
+    io_uring_buf_reg registration = {};
+    registration.ring_addr = (uint64_t)bufferRing;
+    registration.ring_entries = RECV_BUFFERS;
+    registration.bgid = BUFFER_GROUP;
+    if (uringRegister(ring, IORING_REGISTER_PBUF_RING, &registration, 1) != 0)
+        return false;
+    bufferRing->tail = 0;
+    for (unsigned bid = 0; bid < RECV_BUFFERS; bid++)
+        recycle(bid);
+    receiveHeader.msg_namelen = 0;
+    receiveHeader.msg_controllen = CONTROL_BYTES;
+
+    for (int slot = SEND_SLOTS - 1; slot >= 0; slot--)
+        freeSendSlots.push_back(slot);
+    sendLengths.resize(SEND_SLOTS);
+    for (int index = LOG_BUFFERS - 1; index >= 0; index--)
+        freeLogBuffers.push_back(index);
+    logLengths.resize(LOG_BUFFERS);
+    logOffsets.resize(LOG_BUFFERS);
+    if (logFd >= 0)
+        logEnd = std::max<off_t>(0, lseek(logFd, 0, SEEK_END));
+    return true;
+}
+
+io_uring_sqe *UringEngine::nextSqe()
+{
+    if (*sqTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries)
+        enter(0, -1);
+    unsigned index = *sqTail & *sqMask;
+    sqArray[index] = index;
+    io_uring_sqe *sqe = &sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+void UringEngine::publish()
+{
+    __atomic_store_n(sqTail, *sqTail + 1, __ATOMIC_RELEASE);
+}
+
+// Submits the queued entries and, with minComplete > 0, waits until that
+// many completions are ready or timeout ns (< 0 for none) have passed
+void UringEngine::enter(unsigned minComplete, ArqTime timeout)
+{
+    unsigned toSubmit = *sqTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    if (toSubmit == 0 && minComplete == 0)
+        return;
+    unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    timespec ts = toTimespec(std::max<ArqTime>(0, timeout));
+    io_uring_getevents_arg arg = {};
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = (uint64_t)&ts;
+    if (minComplete > 0 && timeout >= 0)
+        uringEnter(ring, toSubmit, minComplete, flags | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    else
+        uringEnter(ring, toSubmit, minComplete, flags, nullptr, _NSIG / 8);
+    counters.syscalls++;
+}
+
+void UringEngine::armReceive()
+{
+    io_uring_sqe *sqe = nextSqe();
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)&receiveHeader;
+    sqe->len = 1;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = OP_RECEIVE << 32;
+    publish();
+    receiving = true;
+}
+
+void UringEngine::recycle(unsigned bid)
+{
+    // Field by field: the ring's tail overlays the first entry's resv
+    io_uring_buf *buffer = &bufferEntries[bufferRing->tail & (RECV_BUFFERS - 1)];
+    buffer->addr = (uint64_t)(receiveBuffers + bid * RECV_BUFFER_BYTES);
+    buffer->len = RECV_BUFFER_BYTES - 1; // Room for the NUL decodeFrame() adds
+    buffer->bid = (uint16_t)bid;
+    __atomic_store_n(&bufferRing->tail, (uint16_t)(bufferRing->tail + 1), __ATOMIC_RELEASE);
+}
+
+void UringEngine::queueSend(int slot)
+{
+    io_uring_sqe *sqe = nextSqe();
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)sendSlot(slot);
+    sqe->len = sendLengths[slot];
+    if (fixedSends)
+        sqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+    sqe->user_data = OP_SEND << 32 | slot;
+    publish();
+    inFlight++;
+}
+
+void UringEngine::send(const char *data, size_t length)
+{
+    if (length > SEND_SLOT_BYTES || freeSendSlots.empty())
+    {
+        // Behind the datagrams already queued
+        enter(0, -1);
+        counters.synchronous++;
+        counters.syscalls++;
+        if (::send(fd, data, length, 0) >= 0)
+            counters.datagramsSent++;
+        return;
+    }
+    int slot = freeSendSlots.back();
+    freeSendSlots.pop_back();
+    std::memcpy(sendSlot(slot), data, length);
+    sendLengths[slot] = length;
+    queueSend(slot);
+}
+
+void UringEngine::writeLog(const char *data, size_t length)
+{
+    counters.logWrites++;
+    off_t offset = logEnd;
+    logEnd += length;
+    if (length > LOG_BUFFER_BYTES || freeLogBuffers.empty())
+    {
+        counters.synchronous++;
+        writeSynchronously(data, length, offset);
+        return;
+    }
+    int index = freeLogBuffers.back();
+    freeLogBuffers.pop_back();
+    std::memcpy(logBuffer(index), data, length);
+    logLengths[index] = length;
+    logOffsets[index] = offset;
+
+    io_uring_sqe *sqe = nextSqe();
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    sqe->fd = logFd;
+    sqe->off = offset;
+    sqe->addr = (uint64_t)logBuffer(index);
+    sqe->len = length;
+    sqe->buf_index = 1;
+    sqe->user_data = OP_LOG << 32 | index;
+    publish();
+    inFlight++;
+}
+
+void UringEngine::writeSynchronously(const char *data, size_t length, off_t offset)
+{
+    while (length > 0)
+    {
+        ssize_t written = pwrite(logFd, data, length, offset);
+        counters.syscalls++;
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        data += written;
+        length -= written;
+        offset += written;
+    }
+}
+
+void UringEngine::wait(ArqTime timeout, DatagramHandler &handler)
+{
+    if (!receiving)
+        armReceive();
+    // Sends and log writes complete without waking the loop; one more is an arrival
+    enter(inFlight + 1, timeout);
+    reap(&handler);
+}
+
+void UringEngine::drain()
+{
+    for (int tries = 0; tries < 10 && (inFlight > 0 || *sqTail != __atomic_load_n(sqHead, __ATOMIC_ACQUIRE)); tries++)
+    {
+        enter(std::max(inFlight, 1u), 100000000);
+        reap(nullptr);
+    }
+}
+
+void UringEngine::reap(DatagramHandler *handler)
+{
+    ArqTime arrival = 0;
+    unsigned head = *cqHead;
+    unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++)
+    {
+        io_uring_cqe cqe = cqes[head & *cqMask];
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+        int index = (int)(cqe.user_data & 0xffffffff);
+
+        switch (cqe.user_data >> 32)
+        {
+        case OP_RECEIVE:
+        {
+            if (!(cqe.flags & IORING_CQE_F_MORE))
+                receiving = false; // Out of buffers; armed again by the next wait()
+            if (cqe.res < 0 || !(cqe.flags & IORING_CQE_F_BUFFER))
+                break;
+            unsigned bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+            char *buffer = receiveBuffers + bid * RECV_BUFFER_BYTES;
+            io_uring_recvmsg_out out;
+            std::memcpy(&out, buffer, sizeof(out));
+            char *payload = buffer + sizeof(out) + receiveHeader.msg_namelen + receiveHeader.msg_controllen;
+            counters.datagramsReceived++;
+            if (out.flags & MSG_TRUNC)
+            {
+                counters.truncated++;
+            }
+            else if (handler)
+            {
+                if (arrival == 0)
+                    arrival = wallClock();
+                msghdr control = {};
+                control.msg_control = buffer + sizeof(out) + receiveHeader.msg_namelen;
+                control.msg_controllen = out.controllen;
+                ArqTime time = arrival;
+                bool stamped = kernelTimestamp(control, time);
+                handler->datagram(payload, out.payloadlen, time, stamped);
+            }
+            recycle(bid);
+            break;
+        }
+        case OP_SEND:
+            inFlight--;
+            if (cqe.res == -EINVAL && fixedSends)
+            {
+                // Fixed-buffer sends arrived in 6.10; send the slot as a plain buffer
+                fixedSends = false;
+                queueSend(index);
+                break;
+            }
+            if (cqe.res >= 0)
+                counters.datagramsSent++;
+            freeSendSlots.push_back(index);
+            break;
+        case OP_LOG:
+        {
+            inFlight--;
+            // Short or failed: finish it here
+            size_t written = cqe.res > 0 ? cqe.res : 0;
+            if (written < logLengths[index])
+            {
+                counters.synchronous++;
+                writeSynchronously(logBuffer(index) + written, logLengths[index] - written, logOffsets[index] + written);
+            }
+            freeLogBuffers.push_back(index);
+            break;
+        }
+        }
+    }
+}
+
+} // namespace
+
+ArqTime wallClock()
+{
+    // CLOCK_REALTIME, the clock of SO_TIMESTAMPING software timestamps
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (ArqTime)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+std::unique_ptr<IoEngine> createEpollEngine(int fd, int logFd)
+{
+    int epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll < 0)
+        return nullptr;
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) != 0)
+    {
+        close(epoll);
+        return nullptr;
+    }
+    return std::unique_ptr<IoEngine>(new EpollEngine(fd, logFd, epoll));
+}
+
+std::unique_ptr<IoEngine> createUringEngine(int fd, int logFd)
+{
+    std::unique_ptr<UringEngine> engine(new UringEngine(fd, logFd));
+    if (!engine->setup())
+        return nullptr;
+    return std::unique_ptr<IoEngine>(engine.release());
+}
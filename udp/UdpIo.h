@@ -0,0 +1,83 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __DATALINKLAYERNETWORK_UDPIO_H_
+#define __DATALINKLAYERNETWORK_UDPIO_H_
+
+#include "Arq.h"
+
+#include <cstddef>
+#include <memory>
+
+/**
+ * Receives the datagrams an IoEngine picks up. data has room for a NUL
+ * after length bytes and is only valid during the call. time is the
+ * kernel's software receive timestamp on CLOCK_REALTIME when there was
+ * one (kernelStamp), the wakeup time otherwise.
+ */
+class DatagramHandler
+{
+public:
+    virtual ~DatagramHandler() {}
+    virtual void datagram(char *data, size_t length, ArqTime time, bool kernelStamp) = 0;
+};
+
+struct IoStats
+{
+    long datagramsSent = 0;
+    long datagramsReceived = 0;
+    long truncated = 0;           // Larger than a receive buffer, dropped
+    long syscalls = 0;            // Every I/O system call, waits included
+    long logWrites = 0;
+    long synchronous = 0;         // uring: sends and log writes that bypassed the ring
+};
+
+/**
+ * Datagram and log file I/O under arq_udp's event loop, on a connected
+ * UDP socket. Datagrams queued with send() leave at the next wait() or
+ * drain(), and their data must stay valid until then; log blocks are
+ * copied and written at the current end of the log file in order.
+ */
+class IoEngine
+{
+public:
+    virtual ~IoEngine() {}
+    virtual const char *name() const = 0;
+
+    virtual void send(const char *data, size_t length) = 0;
+    virtual void writeLog(const char *data, size_t length) = 0;
+
+    // Sends what is queued, then waits up to timeout ns for arrivals
+    virtual void wait(ArqTime timeout, DatagramHandler &handler) = 0;
+
+    // Completes every queued send and log write; later arrivals are dropped
+    virtual void drain() = 0;
+
+    const IoStats &stats() const { return counters; }
+
+protected:
+    IoStats counters;
+};
+
+// Nanoseconds on CLOCK_REALTIME, the clock of receive timestamps
+ArqTime wallClock();
+
+// sendmmsg(), recvmmsg() and write(), waiting in epoll_pwait2()
+std::unique_ptr<IoEngine> createEpollEngine(int fd, int logFd);
+
+// io_uring through raw system calls; nullptr when the kernel refuses it
+std::unique_ptr<IoEngine> createUringEngine(int fd, int logFd);
+
+#endif
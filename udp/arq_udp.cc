@@ -0,0 +1,572 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+//
+// Runs the ARQ core (src/Arq.h) as a real link between two processes over
+// UDP, e.g. on loopback or across a veth pair in a network namespace.
+//
+//   arq_udp -local 9000 -remote 127.0.0.1:9001 -input input0.txt -frames 100000
+//   arq_udp -local 9001 -remote 127.0.0.1:9000
+//
+// A process with -input sends the lines (repeated to -frames); one without
+// only receives, and exits after -idle seconds without traffic. Frames
+// travel as binary datagrams (see encodeFrame). Protocol delays are
+// scaled to wall-clock time by -scale, so the simulation's 0.5 s
+// processing time becomes 0.5 ms at the default of 0.001. Both ends
+// need the same -window and -maxseq.
+//
+// A delayed frame (error code x0x1) can arrive after its retransmission
+// has been delivered. Near-zero propagation makes the window go round a
+// small sequence space in that time, and a stale copy then passes for a
+// new frame. -maxseq therefore defaults to 255, not to the simulation's 7.
+//
+// Socket and log I/O go through an engine (UdpIo.h) chosen with -io. The
+// default, epoll, sends the datagrams that fall due together in one
+// sendmmsg() call and drains arrivals with recvmmsg(); uring does the same
+// work through io_uring with one system call per loop iteration, and
+// falls back to epoll where the kernel lacks it. Arrivals carry
+// SO_TIMESTAMPING software receive timestamps, and the endpoint sees a
+// frame at the time the kernel received it, so RTT samples leave out the
+// time the datagram waited in the socket buffer.
+//
+
+#include "Arq.h"
+#include "LogFormat.h"
+#include "Trace.h"
+#include "UdpIo.h"
+
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <linux/net_tstamp.h>
+#include <memory>
+#include <netdb.h>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const size_t HEADER_BYTES = 14;
+const size_t MAX_DATAGRAM = 65536;
+
+// Datagram: type, flags (1 = last fragment, 2 = compressed), trailer, a
+// reserved byte, then seqNum, ack and fragIndex as 16-bit and the sack
+// bitmap as 32-bit big-endian values (a SACK window is at most 32 frames),
+// then the wire payload without its terminating NUL
+size_t encodeFrame(const ArqFrame &frame, char *out)
+{
+    size_t length = std::strlen(frame.payload);
+    if (HEADER_BYTES + length > MAX_DATAGRAM)
+        length = MAX_DATAGRAM - HEADER_BYTES;
+    uint16_t fields[3] = {htons((uint16_t)frame.seqNum), htons((uint16_t)(int16_t)frame.ack),
+                          htons((uint16_t)frame.fragIndex)};
+    uint32_t sack = htonl((uint32_t)frame.sack);
+    out[0] = (char)frame.type;
+    out[1] = (char)((frame.lastFragment ? 1 : 0) | (frame.compressed ? 2 : 0));
+    out[2] = frame.trailer;
+    out[3] = 0;
+    std::memcpy(out + 4, fields, sizeof(fields));
+    std::memcpy(out + 10, &sack, sizeof(sack));
+    std::memcpy(out + HEADER_BYTES, frame.payload, length);
+    return HEADER_BYTES + length;
+}
+
+// data must have room for a NUL after length bytes
+bool decodeFrame(char *data, size_t length, ArqFrame &frame)
+{
+    if (length < HEADER_BYTES)
+        return false;
+    uint16_t fields[3];
+    uint32_t sack;
+    std::memcpy(fields, data + 4, sizeof(fields));
+    std::memcpy(&sack, data + 10, sizeof(sack));
+    frame.type = (unsigned char)data[0];
+    frame.lastFragment = data[1] & 1;
+    frame.compressed = data[1] & 2;
+    frame.trailer = data[2];
+    frame.seqNum = ntohs(fields[0]);
+    frame.ack = (int16_t)ntohs(fields[1]);
+    frame.sack = (int)ntohl(sack);
+    frame.fragIndex = ntohs(fields[2]);
+    data[length] = '\0';
+    frame.payload = data + HEADER_BYTES;
+    frame.bitLength = 8 * length;
+    return true;
+}
+
+enum EventKind
+{
+    EVENT_DATAGRAM,
+    EVENT_SEND_NEXT,
+    EVENT_RETRANSMIT,
+    EVENT_ACK,
+    EVENT_REASSEMBLY
+};
+
+struct Event
+{
+    ArqTime at;
+    uint64_t order;
+    EventKind kind;
+    int index;           // Frame index of a retransmission timer, outgoing slot of a datagram
+    uint32_t generation; // Timer events are stale once the generation moves on
+
+    bool operator>(const Event &other) const
+    {
+        return at != other.at ? at > other.at : order > other.order;
+    }
+};
+
+class UdpLink : public ArqClock, public ArqTransport, public DatagramHandler
+{
+public:
+    UdpLink(IoEngine &io, const ArqConfig &config, double scale, bool logging);
+
+    ArqEndpoint arq;
+    long delivered = 0;
+    long dataFrames = 0;
+    long kernelTimestamps = 0;
+    ArqTime lastArrival = 0;
+
+    void run(double idleSeconds);
+
+    virtual ArqTime now() const override { return eventTime; }
+    virtual ArqTime fromSeconds(double seconds) const override { return (ArqTime)(seconds * scale * 1e9); }
+    virtual double toSeconds(ArqTime time) const override { return time / (scale * 1e9); }
+    virtual void startTimer(ArqTimer timer, int index, double delay) override;
+    virtual void cancelTimer(ArqTimer timer, int index) override;
+    virtual void scheduleSend(double delay) override;
+
+    virtual void transmit(const ArqFrame &frame, double delay) override;
+    virtual void deliver(std::string_view message, int seqNum) override;
+    virtual void log(const LogRecord &record) override;
+    virtual void logDelayed(const LogRecord &record, double delay) override;
+
+    virtual void datagram(char *data, size_t length, ArqTime time, bool kernelStamp) override;
+
+private:
+    IoEngine &io;
+    double scale;
+    ArqTime eventTime;
+    ArqTime startTime;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+    uint64_t order = 0;
+    std::vector<uint32_t> retransmitGeneration;
+    uint32_t ackGeneration = 0;
+    uint32_t reassemblyGeneration = 0;
+
+    // Encoded datagrams waiting for their send time
+    std::vector<std::string> outgoing;
+    std::vector<int> freeSlots;
+    std::vector<int> batch;              // Slots handed to the engine, free after its wait()
+
+    std::unique_ptr<LogSink> logSink;
+
+    void schedule(EventKind kind, ArqTime at, int index, uint32_t generation);
+    void writeLog(const LogRecord &record, ArqTime at);
+};
+
+UdpLink::UdpLink(IoEngine &io, const ArqConfig &config, double scale, bool logging)
+    : arq(config, *this, *this), io(io), scale(scale)
+{
+    eventTime = startTime = wallClock();
+    retransmitGeneration.resize(arq.sequenceSpace(), 0);
+    if (logging)
+        logSink.reset(new LogSink([&io](const char *data, size_t length) { io.writeLog(data, length); }));
+}
+
+void UdpLink::schedule(EventKind kind, ArqTime at, int index, uint32_t generation)
+{
+    events.push(Event{at, order++, kind, index, generation});
+}
+
+void UdpLink::startTimer(ArqTimer timer, int index, double delay)
+{
+    ArqTime at = eventTime + fromSeconds(delay);
+    switch (timer)
+    {
+    case TIMER_RETRANSMIT:
+        schedule(EVENT_RETRANSMIT, at, index, ++retransmitGeneration[index % arq.sequenceSpace()]);
+        break;
+    case TIMER_ACK:
+        schedule(EVENT_ACK, at, 0, ++ackGeneration);
+        break;
+    case TIMER_REASSEMBLY:
+        schedule(EVENT_REASSEMBLY, at, 0, ++reassemblyGeneration);
+        break;
+    }
+}
+
+void UdpLink::cancelTimer(ArqTimer timer, int index)
+{
+    switch (timer)
+    {
+    case TIMER_RETRANSMIT:
+        retransmitGeneration[index % arq.sequenceSpace()]++;
+        break;
+    case TIMER_ACK:
+        ackGeneration++;
+        break;
+    case TIMER_REASSEMBLY:
+        reassemblyGeneration++;
+        break;
+    }
+}
+
+void UdpLink::scheduleSend(double delay)
+{
+    schedule(EVENT_SEND_NEXT, eventTime + fromSeconds(delay), 0, 0);
+}
+
+void UdpLink::transmit(const ArqFrame &frame, double delay)
+{
+    int slot;
+    if (freeSlots.empty())
+    {
+        slot = outgoing.size();
+        outgoing.emplace_back();
+    }
+    else
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    std::string &datagram = outgoing[slot];
+    datagram.resize(HEADER_BYTES + std::strlen(frame.payload));
+    datagram.resize(encodeFrame(frame, &datagram[0]));
+    if (frame.type == FRAME_DATA || frame.type == FRAME_AGGREGATE)
+        dataFrames++;
+    schedule(EVENT_DATAGRAM, eventTime + fromSeconds(delay), slot, 0);
+}
+
+void UdpLink::deliver(std::string_view message, int seqNum)
+{
+    delivered++;
+    if (logSink)
+    {
+        LogRecord record;
+        record.kind = LogRecord::UPLOAD;
+        record.number = seqNum;
+        record.payload.assign(message);
+        writeLog(record, eventTime);
+    }
+}
+
+void UdpLink::log(const LogRecord &record)
+{
+    if (logSink)
+        writeLog(record, eventTime);
+}
+
+void UdpLink::logDelayed(const LogRecord &record, double delay)
+{
+    // Stamped with the time the simulation would print it
+    if (logSink)
+        writeLog(record, eventTime + fromSeconds(delay));
+}
+
+void UdpLink::writeLog(const LogRecord &record, ArqTime at)
+{
+    char time[64];
+    writePrefix(*logSink, formatTraceTime(time, at - startTime, -9), 0);
+    writeRecord(*logSink, record);
+    logSink->endLine();
+}
+
+void UdpLink::datagram(char *data, size_t length, ArqTime time, bool kernelStamp)
+{
+    // Kernel receive time when SO_TIMESTAMPING delivered one
+    eventTime = time;
+    if (kernelStamp)
+        kernelTimestamps++;
+    ArqFrame frame;
+    if (decodeFrame(data, length, frame))
+        arq.receive(frame);
+    lastArrival = std::max(lastArrival, time);
+}
+
+void UdpLink::run(double idleSeconds)
+{
+    ArqTime idle = (ArqTime)(idleSeconds * 1e9);
+    for (;;)
+    {
+        // Everything that is due, in time order; datagrams due together leave in one call
+        ArqTime now = wallClock();
+        while (!events.empty() && events.top().at <= now)
+        {
+            Event event = events.top();
+            events.pop();
+            eventTime = event.at;
+            switch (event.kind)
+            {
+            case EVENT_DATAGRAM:
+                io.send(outgoing[event.index].data(), outgoing[event.index].size());
+                batch.push_back(event.index);
+                break;
+            case EVENT_SEND_NEXT:
+                arq.sendFrames();
+                break;
+            case EVENT_RETRANSMIT:
+                if (retransmitGeneration[event.index % arq.sequenceSpace()] == event.generation)
+                    arq.retransmitTimeout(event.index);
+                break;
+            case EVENT_ACK:
+                if (ackGeneration == event.generation)
+                    arq.ackTimeout();
+                break;
+            case EVENT_REASSEMBLY:
+                if (reassemblyGeneration == event.generation)
+                    arq.reassemblyTimeout();
+                break;
+            }
+        }
+
+        // A sender is done once everything is acknowledged, a receiver once the line goes quiet
+        bool quiet = now - std::max(lastArrival, startTime) > idle;
+        if (arq.messageCount() > 0 ? arq.allAcknowledged() && (lastArrival == 0 || quiet) : quiet && lastArrival > 0)
+            break;
+
+        // Due datagrams leave as the engine starts to wait
+        ArqTime wait = events.empty() ? idle : std::max<ArqTime>(0, events.top().at - now);
+        io.wait(std::min(wait, idle), *this);
+        for (int slot : batch)
+            freeSlots.push_back(slot);
+        batch.clear();
+    }
+
+    if (logSink)
+        logSink->flush();
+    io.drain();
+}
+
+int openSocket(const char *localPort, const char *remote)
+{
+    std::string host = remote;
+    size_t colon = host.rfind(':');
+    if (colon == std::string::npos)
+        return -1;
+    std::string port = host.substr(colon + 1);
+    host = host.substr(0, colon);
+
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo *peer;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &peer) != 0)
+        return -1;
+
+    int fd = socket(peer->ai_family, SOCK_DGRAM, 0);
+    if (fd >= 0)
+    {
+        sockaddr_storage local = {};
+        socklen_t localLength;
+        if (peer->ai_family == AF_INET6)
+        {
+            sockaddr_in6 *a = (sockaddr_in6 *)&local;
+            a->sin6_family = AF_INET6;
+            a->sin6_port = htons((uint16_t)std::atoi(localPort));
+            a->sin6_addr = in6addr_any;
+            localLength = sizeof(*a);
+        }
+        else
+        {
+            sockaddr_in *a = (sockaddr_in *)&local;
+            a->sin_family = AF_INET;
+            a->sin_port = htons((uint16_t)std::atoi(localPort));
+            a->sin_addr.s_addr = htonl(INADDR_ANY);
+            localLength = sizeof(*a);
+        }
+        int size = 4 << 20;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+        if (bind(fd, (sockaddr *)&local, localLength) != 0 ||
+            connect(fd, peer->ai_addr, peer->ai_addrlen) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(peer);
+
+    // Software receive timestamps; without them arrivals are stamped on wakeup
+    if (fd >= 0)
+    {
+        int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+        if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) != 0)
+            std::fprintf(stderr, "SO_TIMESTAMPING unavailable, using wakeup times\n");
+    }
+    return fd;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const char *localPort = nullptr;
+    const char *remote = nullptr;
+    const char *input = nullptr;
+    const char *logPath = nullptr;
+    std::string engine = "epoll";
+    long frames = 0;
+    double scale = 0.001;
+    double idle = 2;
+    ArqConfig config;
+    config.maxSeqNumber = 255;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string option = argv[i];
+        const char *value = argv[i + 1];
+        if (option == "-local")
+            localPort = value;
+        else if (option == "-remote")
+            remote = value;
+        else if (option == "-input")
+            input = value;
+        else if (option == "-frames")
+            frames = std::atol(value);
+        else if (option == "-scale")
+            scale = std::atof(value);
+        else if (option == "-idle")
+            idle = std::atof(value);
+        else if (option == "-log")
+            logPath = value;
+        else if (option == "-io")
+            engine = value;
+        else if (option == "-window")
+            config.windowSize = std::atoi(value);
+        else if (option == "-maxseq")
+            config.maxSeqNumber = std::atoi(value);
+        else if (option == "-sack")
+            config.selectiveAck = std::atoi(value) != 0;
+        else
+            localPort = nullptr, i = argc;
+    }
+    if (!localPort || !remote || (engine != "epoll" && engine != "uring"))
+    {
+        std::fprintf(stderr,
+                     "usage: %s -local port -remote host:port [-input file] [-frames n] [-scale s]\n"
+                     "          [-idle s] [-log file] [-io epoll|uring] [-window n] [-maxseq n] [-sack 0|1]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    std::vector<std::string> lines;
+    if (input)
+    {
+        std::vector<std::string> pattern;
+        std::ifstream file(input);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            if (line.size() > 5)
+                pattern.push_back(line);
+        }
+        if (pattern.empty())
+        {
+            std::fprintf(stderr, "No input lines in %s\n", input);
+            return 1;
+        }
+        long count = frames > 0 ? frames : (long)pattern.size();
+        for (long i = 0; i < count; i++)
+            lines.push_back(pattern[i % pattern.size()]);
+    }
+
+    int fd = openSocket(localPort, remote);
+    if (fd < 0)
+    {
+        std::fprintf(stderr, "Cannot bind port %s and connect to %s\n", localPort, remote);
+        return 1;
+    }
+
+    int logFd = -1;
+    if (logPath && (logFd = open(logPath, O_WRONLY | O_CREAT | O_CLOEXEC, 0644)) < 0)
+    {
+        std::fprintf(stderr, "Cannot open %s\n", logPath);
+        return 1;
+    }
+    if (logFd >= 0)
+        lseek(logFd, 0, SEEK_END); // Appends to an existing log, as LogSink does
+
+    std::unique_ptr<IoEngine> io;
+    if (engine == "uring" && !(io = createUringEngine(fd, logFd)))
+        std::fprintf(stderr, "io_uring unavailable, using epoll\n");
+    if (!io && !(io = createEpollEngine(fd, logFd)))
+    {
+        std::fprintf(stderr, "Cannot set up epoll\n");
+        return 1;
+    }
+    std::unique_ptr<UdpLink> link;
+    try
+    {
+        link.reset(new UdpLink(*io, config, scale, logPath != nullptr));
+    }
+    catch (const std::invalid_argument &e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 2;
+    }
+
+    ArqTime start = wallClock();
+    try
+    {
+        if (!lines.empty())
+            link->arq.start(std::move(lines));
+        link->run(idle);
+    }
+    catch (const std::runtime_error &e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    double seconds = (link->lastArrival > start ? link->lastArrival - start : wallClock() - start) * 1e-9;
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    double cpu = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+
+    const ArqStats &stats = link->arq.stats();
+    const IoStats &ioStats = io->stats();
+    long messages = link->arq.messageCount() > 0 ? (long)link->arq.messageCount() : link->delivered;
+    std::printf("%-20s %ld messages delivered, %ld sent\n", "messages",
+                link->delivered, (long)link->arq.messageCount());
+    std::printf("%-20s %ld sent, %ld received, %ld truncated\n", "datagrams",
+                ioStats.datagramsSent, ioStats.datagramsReceived, ioStats.truncated);
+    std::printf("%-20s %s, %ld system calls (%.2f per message), %ld log writes, %ld synchronous\n", "io",
+                io->name(), ioStats.syscalls, messages > 0 ? (double)ioStats.syscalls / messages : 0.0,
+                ioStats.logWrites, ioStats.synchronous);
+    std::printf("%-20s %ld data frames, %ld retransmissions, %ld kernel timestamps\n", "frames",
+                link->dataFrames, stats.retransmissions, link->kernelTimestamps);
+    if (link->arq.hasRtt())
+        std::printf("%-20s srtt %.1f us, rto %.1f us\n", "rtt",
+                    link->arq.smoothedRtt() * scale * 1e6, link->arq.currentRto() * scale * 1e6);
+    std::printf("%-20s %.3f s, %.0f messages/s\n", "wall time", seconds, messages / seconds);
+    std::printf("%-20s %.3f s user+system, %.2f us per message\n", "cpu time", cpu,
+                messages > 0 ? cpu * 1e6 / messages : 0.0);
+
+    link.reset();
+    io.reset();
+    close(fd);
+    if (logFd >= 0)
+        close(logFd);
+    return 0;
+}